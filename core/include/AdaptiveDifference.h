@@ -0,0 +1,22 @@
+#pragma once
+
+#include <memory>
+
+#include "Differentiator.h"
+
+namespace matan {
+
+// Per-point adaptive step (Ridders): starting from ctx.h, the step shrinks geometrically and the
+// differences are Richardson-extrapolated in a Neville tableau. Each point stops as soon as its
+// error estimate reaches ctx.tol, or once round-off makes the estimate grow again. End points
+// without room for a central difference use one-sided differences.
+class AdaptiveDifference final : public Differentiator {
+ public:
+  AdaptiveDifference();
+  DerivativeResult differentiate(const DifferentiationContext& ctx) const override;
+  // Same, on nodes and reference values that were already computed for ctx.
+  DerivativeResult differentiateOn(const DifferentiationContext& ctx,
+                                   std::shared_ptr<const DerivativeGrid> grid) const;
+};
+
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "Minimizer.h"
+
+namespace matan {
+
+// Brent's method: parabolic interpolation through the three best points, falling back to a
+// golden-section step whenever the parabola is unreliable. Converges superlinearly on smooth
+// functions and never worse than golden section. The trace records the best point (y) and the
+// second best (z).
+class BrentMinimizer final : public Minimizer {
+ public:
+  BrentMinimizer();
+  MinimizationResult minimize(const MinimizationContext& ctx) const override;
+  // Advances all problems in lockstep with one batched evaluation per round.
+  std::vector<MinimizationResult> minimizeBatch(
+      const Expression& f, std::span<const MinimizationProblem> problems,
+      const TraceOptions& trace = kNoTrace) const override;
+};
+
+}
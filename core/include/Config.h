@@ -12,18 +12,30 @@ struct Config {
     std::string func = "sin(x) + x^2";
     double a = -2.0;
     double b = 2.0;
+    int threads = 0;
   } general;
 
   struct Task1 {
     Task1Method method = Task1Method::Golden;
     double eps = 1e-4;
+    int samples = 1024;
+    int sections = 0;
+    long budget = 0;
+    TraceMode trace = TraceMode::Full;
+    int trace_every = 100;
+    int trace_last = 1000;
   } task1;
 
   struct Task2 {
     Task2Method method = Task2Method::Central;
     std::string dfunc;
     double h = 0.1;
+    double tol = 1e-10;
     bool rmse_sweep = true;
+    int rmse_steps = 5;
+    bool streaming = false;
+    GridKind grid = GridKind::Uniform;
+    long max_points = 1000000;
   } task2;
 
   struct Output {
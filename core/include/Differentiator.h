@@ -1,8 +1,12 @@
 #pragma once
 
+#include <cstddef>
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "TaskTypes.h"
+
 class Expression;
 
 namespace matan {
@@ -11,10 +15,16 @@ class Expression;
 
 struct DifferentiationContext {
   const Expression& f;
-  const Expression& df;
+  // Analytic derivative used as the reference; null means f' comes from differentiating f.
+  const Expression* df = nullptr;
   double a = 0.0;
   double b = 0.0;
   double h = 0.0;
+  // Target error of adaptive methods.
+  double tol = 1e-10;
+  // Adaptive grids start from step h and refine where the error estimate exceeds tol.
+  GridKind grid = GridKind::Uniform;
+  std::size_t max_points = 1000000;
 };
 
 struct DerivativeSample {
@@ -26,13 +36,122 @@ struct DerivativeSample {
   double err = 0.0;
 };
 
+// Columns shared by every method evaluated on the same grid. On uniform grids x is derived from
+// the index and xs stays empty.
+struct DerivativeGrid {
+  double a = 0.0;
+  double h = 0.0;
+  std::vector<double> xs;
+  std::vector<double> fx;
+  std::vector<double> d_true;
+
+  std::size_t size() const {
+    return fx.size();
+  }
+  double x(std::size_t i) const {
+    return xs.empty() ? a + static_cast<double>(i) * h : xs[i];
+  }
+};
+
+struct DerivativeResult;
+
+// Row-wise view of a DerivativeResult for callers that want DerivativeSample records; rows are
+// assembled on access.
+class DerivativeSampleView {
+ public:
+  class iterator {
+   public:
+    using value_type = DerivativeSample;
+    using difference_type = std::ptrdiff_t;
+
+    iterator() = default;
+    iterator(const DerivativeSampleView* view, std::size_t i) : view_(view), i_(i) {}
+
+    DerivativeSample operator*() const {
+      return (*view_)[i_];
+    }
+    iterator& operator++() {
+      ++i_;
+      return *this;
+    }
+    iterator operator++(int) {
+      iterator old = *this;
+      ++i_;
+      return old;
+    }
+    bool operator==(const iterator& other) const {
+      return i_ == other.i_;
+    }
+
+   private:
+    const DerivativeSampleView* view_ = nullptr;
+    std::size_t i_ = 0;
+  };
+
+  explicit DerivativeSampleView(const DerivativeResult& result) : result_(&result) {}
+
+  std::size_t size() const;
+  bool empty() const {
+    return size() == 0;
+  }
+  DerivativeSample operator[](std::size_t i) const;
+  iterator begin() const {
+    return iterator(this, 0);
+  }
+  iterator end() const {
+    return iterator(this, size());
+  }
+
+ private:
+  const DerivativeResult* result_;
+};
+
+// Columnar result: only the estimates are stored per method; x, fx and d_true live in the shared
+// grid and err is computed on access.
 struct DerivativeResult {
   std::string method;
   double h = 0.0;
   double rmse = 0.0;
-  std::vector<DerivativeSample> samples;
+  std::shared_ptr<const DerivativeGrid> grid;
+  std::vector<double> d_est;
+  // Step used at each node; filled only by adaptive methods.
+  std::vector<double> step;
+
+  std::size_t size() const {
+    return d_est.size();
+  }
+  double x(std::size_t i) const {
+    return grid->x(i);
+  }
+  double fx(std::size_t i) const {
+    return grid->fx[i];
+  }
+  double d_true(std::size_t i) const {
+    return grid->d_true[i];
+  }
+  double err(std::size_t i) const {
+    return d_est[i] - grid->d_true[i];
+  }
+  DerivativeSampleView samples() const {
+    return DerivativeSampleView(*this);
+  }
 };
 
+inline std::size_t DerivativeSampleView::size() const {
+  return result_->size();
+}
+
+inline DerivativeSample DerivativeSampleView::operator[](std::size_t i) const {
+  DerivativeSample sample;
+  sample.i = static_cast<int>(i);
+  sample.x = result_->x(i);
+  sample.fx = result_->fx(i);
+  sample.d_true = result_->d_true(i);
+  sample.d_est = result_->d_est[i];
+  sample.err = result_->err(i);
+  return sample;
+}
+
 class Differentiator {
  public:
   virtual ~Differentiator() = default;
@@ -40,9 +159,9 @@ class Differentiator {
 
  protected:
   explicit Differentiator(std::string method_name);
-  void logSample(DerivativeResult& result, int i, double x, double fx, double d_true,
-                 double d_est) const;
-  void finalize(DerivativeResult& result) const;
+  // Wraps per-node estimates on grid and computes their RMSE against d_true.
+  DerivativeResult makeResult(std::shared_ptr<const DerivativeGrid> grid,
+                              std::vector<double> d_est) const;
 
  private:
   std::string method_name_;
@@ -1,12 +1,54 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <span>
 #include <string>
 
-#include <exprtk.hpp>
-
 namespace matan {
 
+struct CompiledExpression;
+
+struct EvalStatus {
+  std::size_t non_finite = 0;
+  std::size_t first_index = 0;
+  double first_x = 0.0;
+
+  bool ok() const {
+    return non_finite == 0;
+  }
+};
+
+// Value with first and second derivative from one forward-mode pass.
+struct Jet {
+  double f = 0.0;
+  double df = 0.0;
+  double d2f = 0.0;
+};
+
+struct JetStatus {
+  EvalStatus f;
+  EvalStatus df;
+
+  bool ok() const {
+    return f.ok() && df.ok();
+  }
+};
+
+// Closed interval [lo, hi]; lo > hi is the empty interval. Bounds may be infinite.
+struct Interval {
+  double lo = 0.0;
+  double hi = 0.0;
+
+  bool empty() const {
+    return lo > hi;
+  }
+};
+
+// Cheap handle to a compiled expression. Construction goes through a process-wide cache keyed by
+// the normalized source, so equal functions are parsed once and copies only share the handle.
+// All evaluation methods may be called concurrently from any number of threads.
 class Expression {
  public:
   explicit Expression(std::string expr);
@@ -15,16 +57,38 @@ class Expression {
   Expression(Expression&& other) noexcept;
   Expression& operator=(Expression&& other) noexcept;
   ~Expression();
+  const std::string& source() const;
   double eval(double x) const;
   double derivative(double x) const;
 
+  // Batched forms never throw on poles: out[i] is written for every point and
+  // mask[i] (if given) is set to 1 where the value is not finite, 0 otherwise.
+  EvalStatus evalBatch(std::span<const double> xs, std::span<double> out,
+                       std::span<std::uint8_t> mask = {}) const;
+  // Evaluates x_i = a + i * h for i = 0..n-1.
+  EvalStatus evalGrid(double a, double h, std::size_t n, std::span<double> out,
+                      std::span<std::uint8_t> mask = {}) const;
+  EvalStatus derivativeBatch(std::span<const double> xs, std::span<double> out,
+                             std::span<std::uint8_t> mask = {}) const;
+
+  Jet evalJet(double x) const;
+  // d2f may be empty when only f and f' are needed.
+  JetStatus evalJetBatch(std::span<const double> xs, std::span<double> f, std::span<double> df,
+                         std::span<double> d2f = {}) const;
+
+  // Guaranteed enclosure of f over x: every finite f(t), t in x, lies in the result, with
+  // rounding errors directed outwards. Points where f is undefined are left out, so the result is
+  // empty when f is finite nowhere on x. Needs the compiled tape; see supportsIntervals().
+  bool supportsIntervals() const;
+  Interval evalInterval(Interval x) const;
+  void evalIntervalBatch(std::span<const Interval> xs, std::span<Interval> out) const;
+
  private:
-  void InitParser();
-  std::string expr_;
-  mutable double x_ = 0.0;
-  std::unique_ptr<exprtk::parser<double>> parser_;
-  mutable exprtk::symbol_table<double> symbol_table_;
-  mutable exprtk::expression<double> exprtk_expr_;
+  std::shared_ptr<const CompiledExpression> impl_;
 };
 
+// Throws the same error as the scalar eval()/derivative() for the first bad point.
+void requireFinite(const EvalStatus& status, const std::string& what = "Function");
+void requireFinite(const JetStatus& status);
+
 }
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "Minimizer.h"
+
+namespace matan {
+
+// Fibonacci search: the optimal interval reduction for a fixed number of evaluations. It plans
+// n evaluations up front, the budget or the fewest that bring b - a down to eps, and shrinks
+// [a, b] to about (b - a) / F(n) using exactly n evaluations of f.
+class FibonacciMinimizer final : public Minimizer {
+ public:
+  FibonacciMinimizer();
+  MinimizationResult minimize(const MinimizationContext& ctx) const override;
+};
+
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "Minimizer.h"
+
+namespace matan {
+
+// Multi-start global search for multimodal functions: f is sampled on a uniform grid of
+// `samples` points in parallel, every sampled local minimum opens a basin between its two
+// neighbours, and the basins are refined concurrently with Brent's method. The result is the
+// best basin, with all basins ranked in `minima`; its trace is the winning refinement.
+class GlobalMinimizer final : public Minimizer {
+ public:
+  explicit GlobalMinimizer(int samples = 1024);
+  MinimizationResult minimize(const MinimizationContext& ctx) const override;
+
+ private:
+  int samples_;
+};
+
+}
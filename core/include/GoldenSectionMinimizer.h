@@ -8,6 +8,10 @@ class GoldenSectionMinimizer final : public Minimizer {
  public:
   GoldenSectionMinimizer();
   MinimizationResult minimize(const MinimizationContext& ctx) const override;
+  // Advances all problems in lockstep with one batched evaluation per round.
+  std::vector<MinimizationResult> minimizeBatch(
+      const Expression& f, std::span<const MinimizationProblem> problems,
+      const TraceOptions& trace = kNoTrace) const override;
 };
 
 }
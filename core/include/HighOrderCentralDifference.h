@@ -0,0 +1,17 @@
+#pragma once
+
+#include "Differentiator.h"
+
+namespace matan {
+
+// Central difference of order 4, 6 or 8 with matching off-centre stencils at the ends.
+class HighOrderCentralDifference final : public Differentiator {
+ public:
+  explicit HighOrderCentralDifference(int order);
+  DerivativeResult differentiate(const DifferentiationContext& ctx) const override;
+
+ private:
+  int order_;
+};
+
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "Minimizer.h"
+
+namespace matan {
+
+// Branch-and-bound global search with interval arithmetic. Boxes of [a, b] are bisected best
+// lower bound first; a box is pruned once its enclosure of f lies above the best sampled value,
+// and finished once it is narrower than eps or, away from the best point, its bound is within
+// rounding of that value. The result is certified: f_lower bounds f from below on all of [a, b].
+// Each iteration is the box being split, with y/fy the best point so far and z/fz the box
+// midpoint and lower bound.
+class IntervalMinimizer final : public Minimizer {
+ public:
+  IntervalMinimizer();
+  MinimizationResult minimize(const MinimizationContext& ctx) const override;
+};
+
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "Minimizer.h"
+
+namespace matan {
+
+// Parallel k-section search for expensive objectives: every round evaluates `sections` equally
+// spaced interior points concurrently and keeps the two cells around the best one, so the
+// bracket shrinks by (sections + 1) / 2 per round. sections = 0 uses one point per thread.
+class KSectionMinimizer final : public Minimizer {
+ public:
+  explicit KSectionMinimizer(int sections = 0);
+  MinimizationResult minimize(const MinimizationContext& ctx) const override;
+
+ private:
+  int sections_;
+};
+
+}
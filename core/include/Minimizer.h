@@ -1,17 +1,48 @@
 #pragma once
 
+#include <functional>
+#include <limits>
+#include <span>
 #include <string>
 #include <vector>
 
 namespace matan {
 
 class Expression;
+struct IterationState;
 
+// What the minimizers keep of their iterations. None compiles the trace out of the loop; Every
+// keeps every `every`-th iteration plus the last; Last keeps the last `last` iterations; Stream
+// hands each iteration to `stream` and leaves MinimizationResult::iterations empty.
+enum class TraceMode { None, Full, Every, Last, Stream };
+
+using TraceCallback = std::function<void(const IterationState&)>;
+
+struct TraceOptions {
+  TraceMode mode = TraceMode::Full;
+  int every = 1;
+  int last = 1;
+  TraceCallback stream;
+};
+
+inline const TraceOptions kNoTrace{TraceMode::None, 1, 1, {}};
+
+// A positive budget caps the evaluations of f; eps still ends the search early. 0 means no cap.
 struct MinimizationContext {
   const Expression& f;
   double a = 0.0;
   double b = 0.0;
   double eps = 0.0;
+  long budget = 0;
+  TraceOptions trace = {};
+};
+
+// One of many independent problems on the same f for Minimizer::minimizeBatch.
+struct MinimizationProblem {
+  double a = 0.0;
+  double b = 0.0;
+  double eps = 0.0;
+  long budget = 0;
 };
 
 struct IterationState {
@@ -26,22 +57,39 @@ struct IterationState {
   double length = 0.0;
 };
 
+struct LocalMinimum {
+  double x = 0.0;
+  double f = 0.0;
+};
+
 struct MinimizationResult {
   double x_min = 0.0;
   double f_min = 0.0;
   std::string method;
+  // Evaluations of f, including the final one at x_min; a jet (f, f', f'') counts as one.
+  long evaluations = 0;
+  // Certified lower bound of f on [a, b] from methods that prove one; -inf otherwise.
+  double f_lower = -std::numeric_limits<double>::infinity();
   std::vector<IterationState> iterations;
+  // Distinct local minima found by global methods, best first; empty for local methods.
+  std::vector<LocalMinimum> minima;
 };
 
 class Minimizer {
  public:
   virtual ~Minimizer() = default;
   virtual MinimizationResult minimize(const MinimizationContext& ctx) const = 0;
+  // results[i] equals minimize() on problems[i] with the same trace options; each problem keeps
+  // its own iterations, and a Stream callback sees the problems' iterations interleaved. The
+  // default solves the problems one after another; methods that can advance them in lockstep
+  // with batched evaluation override it.
+  virtual std::vector<MinimizationResult> minimizeBatch(
+      const Expression& f, std::span<const MinimizationProblem> problems,
+      const TraceOptions& trace = kNoTrace) const;
 
  protected:
   explicit Minimizer(std::string method_name);
-  void logIteration(MinimizationResult& result, int k, double a, double b, double y, double z,
-                    double fy, double fz) const;
+  const std::string& methodName() const;
 
  private:
   std::string method_name_;
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "Minimizer.h"
+
+namespace matan {
+
+// Safeguarded Newton iteration on f'(x) = 0. Steps use f'' from the forward-mode jet, or the
+// secant slope of f' where f'' <= 0, and must land inside the bracket [a, b] kept by the sign of
+// f'; otherwise a golden-section step towards the minimum is taken instead. Converges
+// quadratically near a smooth minimum and stops once [a, b] is within eps. The trace records the
+// previous iterate (y) and the new one (z).
+class NewtonMinimizer final : public Minimizer {
+ public:
+  NewtonMinimizer();
+  MinimizationResult minimize(const MinimizationContext& ctx) const override;
+};
+
+}
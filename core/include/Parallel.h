@@ -0,0 +1,15 @@
+#pragma once
+
+namespace matan {
+
+// Number of worker threads for the parallel loops; 0 keeps the OpenMP default (all cores).
+void setThreadCount(int threads);
+int threadCount();
+
+}
+
+#ifdef _OPENMP
+#define MATAN_OMP_PARALLEL_FOR _Pragma("omp parallel for schedule(static)")
+#else
+#define MATAN_OMP_PARALLEL_FOR
+#endif
@@ -1,16 +1,35 @@
 #pragma once
 
+#include <cstddef>
+#include <fstream>
 #include <string>
 #include <vector>
 
 #include "Differentiator.h"
+#include "Expression.h"
 #include "Minimizer.h"
 #include "Task2Runner.h"
+#include "TaskTypes.h"
 
 namespace matan {
 
+// With trace_streamed the points/interval files are left to a Task1TraceWriter.
 void writeTask1Result(const MinimizationResult& result, const std::string& func_expr, double a,
-                      double b, const std::string& data_dir);
+                      double b, const std::string& data_dir, bool trace_streamed = false);
+
+// Writes task1_<method>_points.dat and task1_<method>_interval.dat one iteration at a time, in
+// the same format as writeTask1Result, for TraceMode::Stream.
+class Task1TraceWriter {
+ public:
+  Task1TraceWriter(const std::string& data_dir, const std::string& func_expr,
+                   const std::string& method);
+  void write(const IterationState& state);
+
+ private:
+  Expression f_;
+  std::ofstream points_out_;
+  std::ofstream interval_out_;
+};
 
 void writeTask2Result(const DerivativeResult& result, const std::string& data_dir);
 
@@ -18,4 +37,17 @@ void writeTask2Rmse(const std::vector<Task2RmseRow>& sweep, const std::string& d
 
 void writeTask2Combined(const Task2Results& results, const std::string& data_dir);
 
+// Writes task2_<method>.dat and task2_all.dat chunk by chunk, in the same format as
+// writeTask2Result and writeTask2Combined, for streamAllDifferences.
+class Task2StreamWriter {
+ public:
+  Task2StreamWriter(const std::string& data_dir, Task2Method method);
+  void write(const Task2Chunk& chunk);
+
+ private:
+  std::size_t column_;
+  std::ofstream method_out_;
+  std::ofstream all_out_;
+};
+
 }
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "Differentiator.h"
+
+namespace matan {
+
+// Richardson extrapolation of the central difference: (4 D(h/2) - D(h)) / 3, fourth order.
+class RichardsonDifference final : public Differentiator {
+ public:
+  RichardsonDifference();
+  DerivativeResult differentiate(const DifferentiationContext& ctx) const override;
+};
+
+}
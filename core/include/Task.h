@@ -1,10 +1,12 @@
 #pragma once
 
+#include <cstddef>
 #include <string>
 #include <variant>
 
 #include "Differentiator.h"
 #include "Minimizer.h"
+#include "TaskTypes.h"
 
 namespace matan {
 
@@ -15,7 +17,14 @@ struct TaskContext {
   double b = 0.0;
   double eps = 1e-4;
   double h = 0.1;
+  double tol = 1e-10;
+  GridKind grid = GridKind::Uniform;
+  std::size_t max_points = 1000000;
   double delta = -1.0;
+  int samples = 1024;
+  int sections = 0;
+  long budget = 0;
+  TraceOptions trace;
 };
 
 using TaskResult = std::variant<MinimizationResult, DerivativeResult>;
@@ -21,4 +21,34 @@ class Task1Golden final : public Task1Base {
   TaskResult run(const TaskContext& ctx) const override;
 };
 
+class Task1Brent final : public Task1Base {
+ public:
+  TaskResult run(const TaskContext& ctx) const override;
+};
+
+class Task1Newton final : public Task1Base {
+ public:
+  TaskResult run(const TaskContext& ctx) const override;
+};
+
+class Task1Global final : public Task1Base {
+ public:
+  TaskResult run(const TaskContext& ctx) const override;
+};
+
+class Task1KSection final : public Task1Base {
+ public:
+  TaskResult run(const TaskContext& ctx) const override;
+};
+
+class Task1Fibonacci final : public Task1Base {
+ public:
+  TaskResult run(const TaskContext& ctx) const override;
+};
+
+class Task1Interval final : public Task1Base {
+ public:
+  TaskResult run(const TaskContext& ctx) const override;
+};
+
 }
@@ -26,4 +26,23 @@ class Task2Central final : public Task2Base {
   TaskResult run(const TaskContext& ctx) const override;
 };
 
+class Task2HighOrderCentral final : public Task2Base {
+ public:
+  explicit Task2HighOrderCentral(int order) : order_(order) {}
+  TaskResult run(const TaskContext& ctx) const override;
+
+ private:
+  int order_;
+};
+
+class Task2Richardson final : public Task2Base {
+ public:
+  TaskResult run(const TaskContext& ctx) const override;
+};
+
+class Task2Adaptive final : public Task2Base {
+ public:
+  TaskResult run(const TaskContext& ctx) const override;
+};
+
 }
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "Differentiator.h"
+#include "Task.h"
+#include "Task2Runner.h"
+#include "TaskTypes.h"
+
+namespace matan {
+
+// Single pass over a differentiation run. Every product is a stage computed on first request from
+// the stages it depends on and kept for the later ones:
+//
+//   grid -> fine -> combined -> result
+//                       \-> rmseSweep <- fine
+//
+// The grid is evaluated once and the refined grid once, so the selected method, the combined
+// output and the first RMSE row all come from the same nodes. The selected method's result is the
+// matching combined column; only the adaptive method runs separately, on the shared grid.
+// Adaptive grids are refined per method and fall back to the independent runners.
+class Task2Pipeline {
+ public:
+  Task2Pipeline(const TaskContext& ctx, Task2Method method, int rmse_steps);
+  ~Task2Pipeline();
+  Task2Pipeline(const Task2Pipeline&) = delete;
+  Task2Pipeline& operator=(const Task2Pipeline&) = delete;
+
+  const DerivativeResult& result();
+  const Task2Results& combined();
+  const std::vector<Task2RmseRow>& rmseSweep();
+
+ private:
+  struct Stages;
+  std::unique_ptr<Stages> stages_;
+};
+
+}
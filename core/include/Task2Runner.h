@@ -1,9 +1,14 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <span>
 #include <string>
 #include <vector>
 
 #include "Differentiator.h"
+#include "TaskTypes.h"
 
 namespace matan {
 
@@ -11,6 +16,10 @@ struct Task2Results {
   DerivativeResult right;
   DerivativeResult left;
   DerivativeResult central;
+  DerivativeResult central4;
+  DerivativeResult central6;
+  DerivativeResult central8;
+  DerivativeResult richardson;
 };
 
 struct Task2RmseRow {
@@ -18,11 +27,52 @@ struct Task2RmseRow {
   double right = 0.0;
   double left = 0.0;
   double central = 0.0;
+  double central4 = 0.0;
+  double central6 = 0.0;
+  double central8 = 0.0;
+  double richardson = 0.0;
 };
 
-Task2Results runAllDifferences(const std::string& f_str, double a, double b, double h);
+// Estimate columns of the combined output follow the order of Task2Method; the adaptive method is
+// per point rather than grid-based and has no column.
+constexpr std::size_t kTask2Methods = 7;
 
-std::vector<Task2RmseRow> runRmseSweep(const std::string& f_str, double a, double b, double h0,
-                                       int steps);
+inline std::size_t task2Column(Task2Method method) {
+  return static_cast<std::size_t>(method);
+}
+
+// One block of streamed output covering grid nodes [begin, begin + x.size()).
+struct Task2Chunk {
+  std::size_t begin = 0;
+  std::span<const double> x;
+  std::span<const double> fx;
+  std::span<const double> d_true;
+  std::array<std::span<const double>, kTask2Methods> d_est;
+};
+
+using Task2ChunkSink = std::function<void(const Task2Chunk&)>;
+
+// df_str is the analytic derivative used as the reference; when empty, f' comes from a
+// forward-mode pass over f.
+Task2Results runAllDifferences(const std::string& f_str, const std::string& df_str, double a,
+                               double b, double h);
+
+// Combined output on an adaptive grid (see buildAdaptiveGrid) refined for the central scheme.
+// Right, left and central use the weights of the actual spacing; the uniform-only methods get NaN.
+Task2Results runAllDifferencesAdaptive(const std::string& f_str, const std::string& df_str,
+                                       double a, double b, double h, double tol,
+                                       std::size_t max_points);
+
+std::vector<Task2RmseRow> runRmseSweep(const std::string& f_str, const std::string& df_str,
+                                       double a, double b, double h0, int steps);
+
+// Same estimates and RMSE as runAllDifferences without materializing the grid: blocks are
+// evaluated with a small halo a few at a time and handed to sink in grid order. Peak memory
+// depends on the thread count, not on the grid size.
+Task2RmseRow streamAllDifferences(const std::string& f_str, const std::string& df_str, double a,
+                                  double b, double h, const Task2ChunkSink& sink = {});
+
+std::vector<Task2RmseRow> streamRmseSweep(const std::string& f_str, const std::string& df_str,
+                                          double a, double b, double h0, int steps);
 
 }
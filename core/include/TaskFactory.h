@@ -8,5 +8,6 @@
 namespace matan {
 
 std::unique_ptr<Task> createTask(const Config& cfg);
+std::unique_ptr<Task> createTask2(Task2Method method);
 
 }
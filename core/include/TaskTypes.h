@@ -5,13 +5,35 @@
 #include <stdexcept>
 #include <string>
 
+#include "Minimizer.h"
+
 namespace matan {
 
 enum class TaskKind : int { Minimize = 1, Differentiate = 2 };
 
-enum class Task1Method { Dichotomy, Golden };
+enum class Task1Method {
+  Dichotomy,
+  Golden,
+  Brent,
+  Newton,
+  Global,
+  KSection,
+  Fibonacci,
+  Interval,
+};
+
+enum class Task2Method {
+  Right,
+  Left,
+  Central,
+  Central4,
+  Central6,
+  Central8,
+  Richardson,
+  Adaptive,
+};
 
-enum class Task2Method { Right, Left, Central };
+enum class GridKind { Uniform, Adaptive };
 
 inline std::string toLower(std::string s) {
   std::transform(s.begin(), s.end(), s.begin(),
@@ -50,6 +72,24 @@ inline Task1Method parseTask1Method(const std::string& value) {
   if (v == "golden") {
     return Task1Method::Golden;
   }
+  if (v == "brent") {
+    return Task1Method::Brent;
+  }
+  if (v == "newton") {
+    return Task1Method::Newton;
+  }
+  if (v == "global") {
+    return Task1Method::Global;
+  }
+  if (v == "ksection") {
+    return Task1Method::KSection;
+  }
+  if (v == "fibonacci") {
+    return Task1Method::Fibonacci;
+  }
+  if (v == "interval") {
+    return Task1Method::Interval;
+  }
   throw std::runtime_error("Unknown task1 method: " + value);
 }
 
@@ -64,9 +104,55 @@ inline Task2Method parseTask2Method(const std::string& value) {
   if (v == "central") {
     return Task2Method::Central;
   }
+  if (v == "central4") {
+    return Task2Method::Central4;
+  }
+  if (v == "central6") {
+    return Task2Method::Central6;
+  }
+  if (v == "central8") {
+    return Task2Method::Central8;
+  }
+  if (v == "richardson") {
+    return Task2Method::Richardson;
+  }
+  if (v == "adaptive") {
+    return Task2Method::Adaptive;
+  }
   throw std::runtime_error("Unknown task2 method: " + value);
 }
 
+inline GridKind parseGridKind(const std::string& value) {
+  std::string v = toLower(value);
+  if (v == "uniform") {
+    return GridKind::Uniform;
+  }
+  if (v == "adaptive") {
+    return GridKind::Adaptive;
+  }
+  throw std::runtime_error("Unknown grid: " + value);
+}
+
+inline TraceMode parseTraceMode(const std::string& value) {
+  std::string v = toLower(value);
+  if (v == "none" || v == "off") {
+    return TraceMode::None;
+  }
+  if (v == "full") {
+    return TraceMode::Full;
+  }
+  if (v == "every") {
+    return TraceMode::Every;
+  }
+  if (v == "last") {
+    return TraceMode::Last;
+  }
+  if (v == "stream") {
+    return TraceMode::Stream;
+  }
+  throw std::runtime_error("Unknown trace: " + value);
+}
+
 inline std::string toString(TaskKind value) {
   switch (value) {
     case TaskKind::Minimize:
@@ -84,6 +170,18 @@ inline std::string toString(Task1Method value) {
       return "dichotomy";
     case Task1Method::Golden:
       return "golden";
+    case Task1Method::Brent:
+      return "brent";
+    case Task1Method::Newton:
+      return "newton";
+    case Task1Method::Global:
+      return "global";
+    case Task1Method::KSection:
+      return "ksection";
+    case Task1Method::Fibonacci:
+      return "fibonacci";
+    case Task1Method::Interval:
+      return "interval";
     default:
       return "unknown";
   }
@@ -97,6 +195,44 @@ inline std::string toString(Task2Method value) {
       return "left";
     case Task2Method::Central:
       return "central";
+    case Task2Method::Central4:
+      return "central4";
+    case Task2Method::Central6:
+      return "central6";
+    case Task2Method::Central8:
+      return "central8";
+    case Task2Method::Richardson:
+      return "richardson";
+    case Task2Method::Adaptive:
+      return "adaptive";
+    default:
+      return "unknown";
+  }
+}
+
+inline std::string toString(GridKind value) {
+  switch (value) {
+    case GridKind::Uniform:
+      return "uniform";
+    case GridKind::Adaptive:
+      return "adaptive";
+    default:
+      return "unknown";
+  }
+}
+
+inline std::string toString(TraceMode value) {
+  switch (value) {
+    case TraceMode::None:
+      return "none";
+    case TraceMode::Full:
+      return "full";
+    case TraceMode::Every:
+      return "every";
+    case TraceMode::Last:
+      return "last";
+    case TraceMode::Stream:
+      return "stream";
     default:
       return "unknown";
   }
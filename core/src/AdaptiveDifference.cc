@@ -0,0 +1,198 @@
+#include "AdaptiveDifference.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "DiffCommon.h"
+#include "Expression.h"
+#include "NonUniformGrid.h"
+#include "Parallel.h"
+
+namespace matan {
+
+namespace {
+
+constexpr std::size_t kTableau = 10;
+constexpr double kShrink = 1.4;
+constexpr double kSafe = 2.0;
+
+// Ridders' tableau for the nodes [begin, end) of grid, run for all of them together so every
+// level is one batched evaluation of the still-active points.
+class RiddersBlock {
+ public:
+  RiddersBlock(const DerivativeGrid& grid, std::size_t begin, std::size_t end, double a, double b,
+               double h0)
+      : grid_(grid), begin_(begin), len_(end - begin) {
+    dir_.resize(len_);
+    hh_.resize(len_);
+    err_.assign(len_, std::numeric_limits<double>::infinity());
+    ans_.resize(len_);
+    ans_h_.resize(len_);
+    done_.assign(len_, 0);
+    prev_.resize(kTableau * len_);
+    cur_.resize(kTableau * len_);
+    for (std::size_t k = 0; k < len_; ++k) {
+      double x = grid.x(begin + k);
+      if (x - h0 >= a && x + h0 <= b) {
+        dir_[k] = 0;
+        hh_[k] = h0;
+      } else if (b - x >= x - a) {
+        dir_[k] = 1;
+        hh_[k] = std::min(h0, b - x);
+      } else {
+        dir_[k] = -1;
+        hh_[k] = std::min(h0, x - a);
+      }
+    }
+  }
+
+  // Returns the first non-finite evaluation, if any; the caller reports it.
+  EvalStatus run(const Expression& f, double tol, double* d_est, double* step) {
+    std::vector<std::size_t> active;
+    std::vector<double> xs;
+    std::vector<double> fs;
+    for (std::size_t level = 0; level < kTableau; ++level) {
+      active.clear();
+      for (std::size_t k = 0; k < len_; ++k) {
+        if (!done_[k]) {
+          active.push_back(k);
+        }
+      }
+      if (active.empty()) {
+        break;
+      }
+
+      // One point per active node (x + h, or x -/+ h one-sided), then x - h for central nodes.
+      xs.clear();
+      for (std::size_t k : active) {
+        double x = grid_.x(begin_ + k);
+        xs.push_back(dir_[k] < 0 ? x - hh_[k] : x + hh_[k]);
+      }
+      for (std::size_t k : active) {
+        if (dir_[k] == 0) {
+          xs.push_back(grid_.x(begin_ + k) - hh_[k]);
+        }
+      }
+      fs.resize(xs.size());
+      EvalStatus status = f.evalBatch(xs, fs);
+      if (!status.ok()) {
+        return status;
+      }
+
+      std::size_t minus = active.size();
+      for (std::size_t m = 0; m < active.size(); ++m) {
+        std::size_t k = active[m];
+        double fx = grid_.fx[begin_ + k];
+        double a0 = 0.0;
+        double step_fac = kShrink;
+        if (dir_[k] == 0) {
+          a0 = (fs[m] - fs[minus++]) / (2.0 * hh_[k]);
+          step_fac = kShrink * kShrink;
+        } else {
+          a0 = (fs[m] - fx) / (static_cast<double>(dir_[k]) * hh_[k]);
+        }
+        update(k, level, a0, step_fac, tol);
+        hh_[k] /= kShrink;
+      }
+      std::swap(prev_, cur_);
+    }
+
+    for (std::size_t k = 0; k < len_; ++k) {
+      d_est[k] = ans_[k];
+      step[k] = ans_h_[k];
+    }
+    return {};
+  }
+
+ private:
+  // Adds column `level` of the tableau for node k; central differences have an error series in
+  // h^2, one-sided ones in h, hence the different extrapolation factors.
+  void update(std::size_t k, std::size_t level, double a0, double step_fac, double tol) {
+    double* cur = cur_.data();
+    const double* prev = prev_.data();
+    cur[k] = a0;
+    if (level == 0) {
+      ans_[k] = a0;
+      ans_h_[k] = hh_[k];
+      return;
+    }
+    double fac = step_fac;
+    for (std::size_t j = 1; j <= level; ++j) {
+      double c = (cur[(j - 1) * len_ + k] * fac - prev[(j - 1) * len_ + k]) / (fac - 1.0);
+      cur[j * len_ + k] = c;
+      fac *= step_fac;
+      double errt = std::max(std::fabs(c - cur[(j - 1) * len_ + k]),
+                             std::fabs(c - prev[(j - 1) * len_ + k]));
+      if (errt <= err_[k]) {
+        err_[k] = errt;
+        ans_[k] = c;
+        ans_h_[k] = hh_[k];
+      }
+    }
+    double drift = std::fabs(cur[level * len_ + k] - prev[(level - 1) * len_ + k]);
+    if (err_[k] <= tol || drift >= kSafe * err_[k]) {
+      done_[k] = 1;
+    }
+  }
+
+  const DerivativeGrid& grid_;
+  std::size_t begin_;
+  std::size_t len_;
+  std::vector<int> dir_;
+  std::vector<double> hh_;
+  std::vector<double> err_;
+  std::vector<double> ans_;
+  std::vector<double> ans_h_;
+  std::vector<std::uint8_t> done_;
+  std::vector<double> prev_;
+  std::vector<double> cur_;
+};
+
+}
+
+AdaptiveDifference::AdaptiveDifference() : Differentiator("adaptive") {}
+
+DerivativeResult AdaptiveDifference::differentiate(const DifferentiationContext& ctx) const {
+  auto grid = ctx.grid == GridKind::Adaptive
+                  ? buildAdaptiveGrid(ctx.f, ctx.df, ctx.a, ctx.b, ctx.h, ctx.tol, 2,
+                                      ctx.max_points)
+                  : buildGrid(ctx.f, ctx.df, ctx.a, ctx.b, ctx.h);
+  return differentiateOn(ctx, shareGrid(std::move(grid)));
+}
+
+DerivativeResult AdaptiveDifference::differentiateOn(const DifferentiationContext& ctx,
+                                                     std::shared_ptr<const DerivativeGrid> grid)
+    const {
+  if (!(ctx.tol > 0.0)) {
+    throw std::runtime_error("Invalid tol: must be positive");
+  }
+  std::size_t n = grid->size();
+  std::vector<double> d_est(n);
+  std::vector<double> step(n);
+  std::size_t blocks = gridBlockCount(n);
+  std::vector<EvalStatus> status(blocks);
+
+  MATAN_OMP_PARALLEL_FOR
+  for (std::ptrdiff_t blk = 0; blk < static_cast<std::ptrdiff_t>(blocks); ++blk) {
+    std::size_t begin = static_cast<std::size_t>(blk) * kGridBlock;
+    std::size_t end = gridBlockEnd(static_cast<std::size_t>(blk), n);
+    RiddersBlock ridders(*grid, begin, end, ctx.a, ctx.b, ctx.h);
+    status[blk] = ridders.run(ctx.f, ctx.tol, d_est.data() + begin, step.data() + begin);
+  }
+  for (const auto& s : status) {
+    requireFinite(s);
+  }
+
+  auto result = makeResult(std::move(grid), std::move(d_est));
+  result.step = std::move(step);
+  return result;
+}
+
+}
@@ -0,0 +1,29 @@
+#include "BrentMinimizer.h"
+
+#include <vector>
+
+#include "Expression.h"
+#include "LineSearch.h"
+#include "TraceSink.h"
+
+namespace matan {
+
+BrentMinimizer::BrentMinimizer() : Minimizer("brent") {}
+
+MinimizationResult BrentMinimizer::minimize(const MinimizationContext& ctx) const {
+  BrentSearch search(ctx.a, ctx.b, ctx.eps, ctx.budget);
+  return runTraced(ctx.trace, methodName(), [&](MinimizationResult& result, auto& sink) {
+    runSearch(ctx.f, search, sink);
+    result.x_min = search.x_min();
+    result.f_min = search.f_min();
+    result.evaluations = search.evaluations();
+  });
+}
+
+std::vector<MinimizationResult> BrentMinimizer::minimizeBatch(
+    const Expression& f, std::span<const MinimizationProblem> problems,
+    const TraceOptions& trace) const {
+  return minimizeLockstep<BrentSearch>(f, problems, methodName(), trace);
+}
+
+}
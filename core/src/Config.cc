@@ -23,12 +23,44 @@ Config Config::load(const std::string& path) {
   cfg.general.func = ini.GetValue("general", "func", cfg.general.func.c_str());
   cfg.general.a = ini.GetDoubleValue("general", "a", cfg.general.a);
   cfg.general.b = ini.GetDoubleValue("general", "b", cfg.general.b);
+  cfg.general.threads =
+      static_cast<int>(ini.GetLongValue("general", "threads", cfg.general.threads));
+  if (cfg.general.threads < 0) {
+    throw std::runtime_error("Invalid threads: must be non-negative");
+  }
 
   const char* task1_method = ini.GetValue("task1", "method", nullptr);
   if (task1_method) {
     cfg.task1.method = parseTask1Method(task1_method);
   }
   cfg.task1.eps = ini.GetDoubleValue("task1", "eps", cfg.task1.eps);
+  cfg.task1.samples = static_cast<int>(ini.GetLongValue("task1", "samples", cfg.task1.samples));
+  if (cfg.task1.samples < 3) {
+    throw std::runtime_error("Invalid samples: need at least 3 points");
+  }
+  cfg.task1.sections =
+      static_cast<int>(ini.GetLongValue("task1", "sections", cfg.task1.sections));
+  if (cfg.task1.sections < 0 || cfg.task1.sections == 1) {
+    throw std::runtime_error("Invalid sections: need at least 2 points per round, or 0 for auto");
+  }
+  cfg.task1.budget = ini.GetLongValue("task1", "budget", cfg.task1.budget);
+  if (cfg.task1.budget < 0) {
+    throw std::runtime_error("Invalid budget: must be non-negative");
+  }
+  const char* task1_trace = ini.GetValue("task1", "trace", nullptr);
+  if (task1_trace) {
+    cfg.task1.trace = parseTraceMode(task1_trace);
+  }
+  cfg.task1.trace_every =
+      static_cast<int>(ini.GetLongValue("task1", "trace_every", cfg.task1.trace_every));
+  if (cfg.task1.trace_every < 1) {
+    throw std::runtime_error("Invalid trace_every: must be at least 1");
+  }
+  cfg.task1.trace_last =
+      static_cast<int>(ini.GetLongValue("task1", "trace_last", cfg.task1.trace_last));
+  if (cfg.task1.trace_last < 1) {
+    throw std::runtime_error("Invalid trace_last: must be at least 1");
+  }
 
   const char* task2_method = ini.GetValue("task2", "method", nullptr);
   if (task2_method) {
@@ -39,7 +71,25 @@ Config Config::load(const std::string& path) {
     cfg.task2.dfunc = task2_dfunc;
   }
   cfg.task2.h = ini.GetDoubleValue("task2", "h", cfg.task2.h);
+  cfg.task2.tol = ini.GetDoubleValue("task2", "tol", cfg.task2.tol);
+  if (!(cfg.task2.tol > 0.0)) {
+    throw std::runtime_error("Invalid tol: must be positive");
+  }
   cfg.task2.rmse_sweep = ini.GetBoolValue("task2", "rmse_sweep", cfg.task2.rmse_sweep);
+  cfg.task2.rmse_steps =
+      static_cast<int>(ini.GetLongValue("task2", "rmse_steps", cfg.task2.rmse_steps));
+  if (cfg.task2.rmse_steps < 1) {
+    throw std::runtime_error("Invalid rmse_steps: must be positive");
+  }
+  cfg.task2.streaming = ini.GetBoolValue("task2", "streaming", cfg.task2.streaming);
+  const char* task2_grid = ini.GetValue("task2", "grid", nullptr);
+  if (task2_grid) {
+    cfg.task2.grid = parseGridKind(task2_grid);
+  }
+  cfg.task2.max_points = ini.GetLongValue("task2", "max_points", cfg.task2.max_points);
+  if (cfg.task2.max_points < 3) {
+    throw std::runtime_error("Invalid max_points: need at least 3 points");
+  }
 
   cfg.output.data_dir = ini.GetValue("output", "data_dir", cfg.output.data_dir.c_str());
 
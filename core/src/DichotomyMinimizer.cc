@@ -5,6 +5,8 @@
 #include <stdexcept>
 
 #include "Expression.h"
+#include "LineSearch.h"
+#include "TraceSink.h"
 
 namespace matan {
 
@@ -25,54 +27,60 @@ MinimizationResult DichotomyMinimizer::minimize(const MinimizationContext& ctx)
   if (eps < kMinEps) {
     eps = kMinEps;
   }
+  // An interval already within tolerance only costs the midpoint.
+  checkBudget(ctx.budget, (b - a) <= 2.0 * eps ? 1 : 3, "dichotomy");
 
-  MinimizationResult result;
-  if ((b - a) <= 2.0 * eps) {
-    result.x_min = 0.5 * (a + b);
-    result.f_min = f.eval(result.x_min);
-    return result;
-  }
+  return runTraced(ctx.trace, methodName(), [&](MinimizationResult& result, auto& sink) {
+    if ((b - a) <= 2.0 * eps) {
+      result.x_min = 0.5 * (a + b);
+      result.f_min = f.eval(result.x_min);
+      result.evaluations = 1;
+      return;
+    }
 
-  double delta = delta_;
-  if (delta <= 0.0) {
-    delta = eps * 0.5;
-  }
-  if (delta <= 0.0) {
-    throw std::runtime_error("Invalid delta: must be positive");
-  }
-  double max_delta = 0.25 * (b - a);
-  double min_delta = std::max(kMinEps * 0.5, std::numeric_limits<double>::epsilon());
-  delta = std::clamp(delta, min_delta, max_delta);
+    double delta = delta_;
+    if (delta <= 0.0) {
+      delta = eps * 0.5;
+    }
+    if (delta <= 0.0) {
+      throw std::runtime_error("Invalid delta: must be positive");
+    }
+    double max_delta = 0.25 * (b - a);
+    double min_delta = std::max(kMinEps * 0.5, std::numeric_limits<double>::epsilon());
+    delta = std::clamp(delta, min_delta, max_delta);
 
-  int k = 0;
-  const int max_iters = 2'000'000;
+    int k = 0;
+    const int max_iters = 2'000'000;
 
-  while (true) {
-    double mid = 0.5 * (a + b);
-    double y = mid - delta;
-    double z = mid + delta;
-    double fy = f.eval(y);
-    double fz = f.eval(z);
-    logIteration(result, k, a, b, y, z, fy, fz);
+    while (true) {
+      double mid = 0.5 * (a + b);
+      double y = mid - delta;
+      double z = mid + delta;
+      double fy = f.eval(y);
+      double fz = f.eval(z);
+      result.evaluations += 2;
+      sink(k, a, b, y, z, fy, fz);
 
-    if (fy <= fz) {
-      b = z;
-    } else {
-      a = y;
-    }
+      if (fy <= fz) {
+        b = z;
+      } else {
+        a = y;
+      }
 
-    if ((b - a) <= 2.0 * eps) {
-      break;
-    }
-    ++k;
-    if (k > max_iters) {
-      throw std::runtime_error("DichotomyMinimizer: iteration limit exceeded; eps may be too small");
+      // Another pair must leave an evaluation for the midpoint.
+      if ((b - a) <= 2.0 * eps || (ctx.budget > 0 && result.evaluations + 3 > ctx.budget)) {
+        break;
+      }
+      ++k;
+      if (k > max_iters) {
+        throw std::runtime_error("DichotomyMinimizer: iteration limit exceeded; eps may be too small");
+      }
     }
-  }
 
-  result.x_min = 0.5 * (a + b);
-  result.f_min = f.eval(result.x_min);
-  return result;
+    result.x_min = 0.5 * (a + b);
+    result.f_min = f.eval(result.x_min);
+    ++result.evaluations;
+  });
 }
 
 }
@@ -1,20 +1,109 @@
 #pragma once
 
+#include <algorithm>
 #include <cmath>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <span>
 #include <stdexcept>
+#include <string>
+#include <utility>
 #include <vector>
 
+#include "Differentiator.h"
 #include "Expression.h"
+#include "Parallel.h"
+#include "Reduction.h"
 
 namespace matan {
 
+// Parallel loops work on fixed blocks and reductions combine per-block partials with a fixed
+// pairwise tree (Reduction.h), so every result is bit-identical whatever the thread count.
+constexpr std::size_t kGridBlock = 4096;
+
+inline std::size_t gridBlockCount(std::size_t n) {
+  return (n + kGridBlock - 1) / kGridBlock;
+}
+
+inline std::size_t gridBlockEnd(std::size_t blk, std::size_t n) {
+  return std::min(n, (blk + 1) * kGridBlock);
+}
+
+// Uniform grids have x[i] = a + i * h. Non-uniform grids keep h as the initial spacing and only x
+// is authoritative.
 struct GridData {
+  double a = 0.0;
   double h = 0.0;
+  bool uniform = true;
   std::vector<double> x;
   std::vector<double> y;
+  std::vector<double> d_true;
 };
 
-inline GridData buildGrid(const Expression& f, double a, double b, double h) {
+inline double rmseAgainst(std::span<const double> d, std::span<const double> ref) {
+  std::size_t n = d.size();
+  if (n == 0) {
+    return 0.0;
+  }
+  std::vector<double> partials(gridBlockCount(n));
+  MATAN_OMP_PARALLEL_FOR
+  for (std::ptrdiff_t blk = 0; blk < static_cast<std::ptrdiff_t>(partials.size()); ++blk) {
+    std::size_t begin = static_cast<std::size_t>(blk) * kGridBlock;
+    std::size_t end = gridBlockEnd(static_cast<std::size_t>(blk), n);
+    partials[blk] = sumSquaredDifferences(d.data() + begin, ref.data() + begin, end - begin);
+  }
+  return std::sqrt(pairwiseSum(partials) / static_cast<double>(n));
+}
+
+// Compiles the user-supplied analytic derivative; an empty source means there is none.
+inline std::optional<Expression> compileDerivative(const std::string& source) {
+  if (source.empty()) {
+    return std::nullopt;
+  }
+  return Expression(source);
+}
+
+// y = f(x), the reference d = f'(x) and, if d2s is not empty, f''(x) in one batched pass. An
+// analytic derivative df, when given, is evaluated directly (with its own forward pass for f'');
+// otherwise both come from the forward-mode pass over f.
+inline JetStatus evalWithReference(const Expression& f, const Expression* df,
+                                   std::span<const double> xs, std::span<double> ys,
+                                   std::span<double> ds, std::span<double> d2s = {}) {
+  if (!df) {
+    return f.evalJetBatch(xs, ys, ds, d2s);
+  }
+  JetStatus status;
+  status.f = f.evalBatch(xs, ys);
+  status.df = d2s.empty() ? df->evalBatch(xs, ds) : df->evalJetBatch(xs, ds, d2s).f;
+  return status;
+}
+
+// evalWithReference over a whole grid in parallel blocks, failing on the first non-finite f or f'.
+inline void evalReference(const Expression& f, const Expression* df, std::span<const double> xs,
+                          std::span<double> ys, std::span<double> ds,
+                          std::span<double> d2s = {}) {
+  std::size_t count = xs.size();
+  std::size_t blocks = gridBlockCount(count);
+  std::vector<JetStatus> status(blocks);
+  MATAN_OMP_PARALLEL_FOR
+  for (std::ptrdiff_t blk = 0; blk < static_cast<std::ptrdiff_t>(blocks); ++blk) {
+    std::size_t begin = static_cast<std::size_t>(blk) * kGridBlock;
+    std::size_t len = gridBlockEnd(static_cast<std::size_t>(blk), count) - begin;
+    status[blk] = evalWithReference(f, df, xs.subspan(begin, len), ys.subspan(begin, len),
+                                    ds.subspan(begin, len),
+                                    d2s.empty() ? std::span<double>() : d2s.subspan(begin, len));
+  }
+  for (const auto& s : status) {
+    requireFinite(s.f);
+  }
+  for (const auto& s : status) {
+    requireFinite(s.df, "Derivative");
+  }
+}
+
+// Number of nodes of the uniform grid a, a + h, ..., b; throws unless h divides [a, b].
+inline std::size_t gridPointCount(double a, double b, double h) {
   if (a >= b) {
     throw std::runtime_error("Invalid interval: a must be less than b");
   }
@@ -24,36 +113,92 @@ inline GridData buildGrid(const Expression& f, double a, double b, double h) {
 
   double span = b - a;
   double n_raw = span / h;
-  int n = static_cast<int>(std::round(n_raw));
+  long long n = std::llround(n_raw);
   if (n < 2) {
     throw std::runtime_error("Invalid grid: need at least 3 points");
   }
   if (std::fabs(n_raw - static_cast<double>(n)) > 1e-9) {
     throw std::runtime_error("Invalid h: (b - a) must be divisible by h");
   }
+  return static_cast<std::size_t>(n) + 1;
+}
 
+inline GridData buildGrid(const Expression& f, const Expression* df, double a, double b,
+                          double h) {
+  std::size_t count = gridPointCount(a, b, h);
   GridData grid;
+  grid.a = a;
   grid.h = h;
-  grid.x.reserve(static_cast<std::size_t>(n) + 1);
-  grid.y.reserve(static_cast<std::size_t>(n) + 1);
-
-  for (int i = 0; i <= n; ++i) {
-    double xi = a + static_cast<double>(i) * h;
-    grid.x.push_back(xi);
-    grid.y.push_back(f.eval(xi));
+  grid.x.resize(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    grid.x[i] = a + static_cast<double>(i) * h;
   }
+  grid.y.resize(count);
+  grid.d_true.resize(count);
+  evalReference(f, df, grid.x, grid.y, grid.d_true);
 
   return grid;
 }
 
-inline double leftBoundaryDerivative(const std::vector<double>& y, double h) {
-  return (-3.0 * y[0] + 4.0 * y[1] - y[2]) / (2.0 * h);
+// Halves the step of a grid built from a: even nodes keep their values (a + 2i * h/2 is exactly
+// a + i * h), only the new midpoints are evaluated.
+inline GridData refineGrid(const Expression& f, const Expression* df, const GridData& coarse,
+                           double a) {
+  std::size_t coarse_count = coarse.x.size();
+  if (coarse_count < 2) {
+    throw std::runtime_error("Invalid grid: need at least 2 points to refine");
+  }
+
+  GridData grid;
+  grid.a = a;
+  grid.h = coarse.h * 0.5;
+  std::size_t mids = coarse_count - 1;
+  std::vector<double> mx(mids);
+  std::vector<double> my(mids);
+  std::vector<double> md(mids);
+  for (std::size_t j = 0; j < mids; ++j) {
+    mx[j] = a + static_cast<double>(2 * j + 1) * grid.h;
+  }
+  evalReference(f, df, mx, my, md);
+
+  std::size_t count = 2 * mids + 1;
+  grid.x.resize(count);
+  grid.y.resize(count);
+  grid.d_true.resize(count);
+  MATAN_OMP_PARALLEL_FOR
+  for (std::ptrdiff_t j = 0; j < static_cast<std::ptrdiff_t>(mids); ++j) {
+    grid.x[2 * j] = coarse.x[j];
+    grid.y[2 * j] = coarse.y[j];
+    grid.d_true[2 * j] = coarse.d_true[j];
+    grid.x[2 * j + 1] = mx[j];
+    grid.y[2 * j + 1] = my[j];
+    grid.d_true[2 * j + 1] = md[j];
+  }
+  grid.x[count - 1] = coarse.x[mids];
+  grid.y[count - 1] = coarse.y[mids];
+  grid.d_true[count - 1] = coarse.d_true[mids];
+  return grid;
 }
 
-inline double rightBoundaryDerivative(const std::vector<double>& y, double h) {
-  std::size_t n = y.size();
-  return (y[n - 3] - 4.0 * y[n - 2] + 3.0 * y[n - 1]) / (2.0 * h);
+inline void requireUniformGrid(const DifferentiationContext& ctx, const std::string& method) {
+  if (ctx.grid != GridKind::Uniform) {
+    throw std::runtime_error("Method " + method + " requires a uniform grid");
+  }
 }
 
+// Hands the function values and reference derivative over to a result grid; x is kept only for
+// non-uniform grids.
+inline std::shared_ptr<const DerivativeGrid> shareGrid(GridData&& grid) {
+  auto shared = std::make_shared<DerivativeGrid>();
+  shared->a = grid.a;
+  shared->h = grid.h;
+  if (!grid.uniform) {
+    shared->xs = std::move(grid.x);
+  }
+  shared->fx = std::move(grid.y);
+  shared->d_true = std::move(grid.d_true);
+  grid.x.clear();
+  return shared;
 }
 
+}
@@ -0,0 +1,1066 @@
+#include "ExprTape.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace matan {
+
+// Each kernel is cloned for AVX-512, AVX2 and the baseline ISA; the loader picks the best one
+// for the running CPU. Instructions never fuse operations, so all clones produce identical bits.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && !defined(_WIN32) && \
+    !defined(__APPLE__)
+#define MATAN_TAPE_KERNEL __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define MATAN_TAPE_KERNEL
+#endif
+
+namespace {
+
+class Lowering {
+ public:
+  std::uint32_t emit(const ExprNodePtr& node) {
+    switch (node->op) {
+      case ExprOp::Var:
+        return 0;
+      case ExprOp::Const: {
+        std::uint32_t d = alloc();
+        push(TapeOp::Const, d, 0, 0, node->value);
+        return d;
+      }
+      default:
+        break;
+    }
+    if (isUnaryOp(node->op)) {
+      std::uint32_t a = emit(node->lhs);
+      release(a);
+      std::uint32_t d = alloc();
+      push(unaryOp(node->op), d, a, 0, 0.0);
+      return d;
+    }
+    const ExprNodePtr& lhs = node->lhs;
+    const ExprNodePtr& rhs = node->rhs;
+    if (rhs->op == ExprOp::Const) {
+      std::uint32_t a = emit(lhs);
+      if (node->op == ExprOp::Pow && rhs->value != 2.0 && isSmallInteger(rhs->value)) {
+        return emitIntegerPow(a, static_cast<int>(rhs->value));
+      }
+      release(a);
+      std::uint32_t d = alloc();
+      if (node->op == ExprOp::Pow && rhs->value == 2.0) {
+        push(TapeOp::Square, d, a, 0, 0.0);
+      } else {
+        push(withRightConst(node->op), d, a, 0, rhs->value);
+      }
+      return d;
+    }
+    if (lhs->op == ExprOp::Const) {
+      std::uint32_t b = emit(rhs);
+      release(b);
+      std::uint32_t d = alloc();
+      push(withLeftConst(node->op), d, b, 0, lhs->value);
+      return d;
+    }
+    std::uint32_t a = emit(lhs);
+    std::uint32_t b = emit(rhs);
+    release(a);
+    release(b);
+    std::uint32_t d = alloc();
+    push(binaryOp(node->op), d, a, b, 0.0);
+    return d;
+  }
+
+  std::vector<TapeInstr> code;
+  std::uint32_t next = 1;
+
+ private:
+  static bool isSmallInteger(double v) {
+    return v == std::trunc(v) && std::abs(v) <= 64.0 && v != 0.0;
+  }
+
+  // Square-and-multiply chain, the same scheme exprtk uses for constant integer exponents.
+  std::uint32_t emitIntegerPow(std::uint32_t a, int exponent) {
+    unsigned e = static_cast<unsigned>(exponent < 0 ? -exponent : exponent);
+    std::vector<std::uint32_t> temps;
+    std::uint32_t base = a;
+    std::uint32_t result = 0;
+    bool has_result = false;
+    while (true) {
+      if (e & 1u) {
+        if (!has_result) {
+          result = base;
+          has_result = true;
+        } else {
+          std::uint32_t d = alloc();
+          temps.push_back(d);
+          push(TapeOp::Mul, d, result, base, 0.0);
+          result = d;
+        }
+      }
+      e >>= 1u;
+      if (e == 0) {
+        break;
+      }
+      std::uint32_t d = alloc();
+      temps.push_back(d);
+      push(TapeOp::Square, d, base, 0, 0.0);
+      base = d;
+    }
+    if (exponent < 0) {
+      std::uint32_t d = alloc();
+      temps.push_back(d);
+      push(TapeOp::CDiv, d, result, 0, 1.0);
+      result = d;
+    }
+    for (std::uint32_t t : temps) {
+      if (t != result) {
+        release(t);
+      }
+    }
+    if (a != result) {
+      release(a);
+    }
+    return result;
+  }
+
+  std::uint32_t alloc() {
+    if (!free_.empty()) {
+      std::uint32_t r = free_.back();
+      free_.pop_back();
+      return r;
+    }
+    return next++;
+  }
+
+  void release(std::uint32_t r) {
+    if (r != 0) {
+      free_.push_back(r);
+    }
+  }
+
+  void push(TapeOp op, std::uint32_t d, std::uint32_t a, std::uint32_t b, double imm) {
+    code.push_back(TapeInstr{op, d, a, b, imm});
+  }
+
+  static TapeOp binaryOp(ExprOp op) {
+    switch (op) {
+      case ExprOp::Add:
+        return TapeOp::Add;
+      case ExprOp::Sub:
+        return TapeOp::Sub;
+      case ExprOp::Mul:
+        return TapeOp::Mul;
+      case ExprOp::Div:
+        return TapeOp::Div;
+      default:
+        return TapeOp::Pow;
+    }
+  }
+
+  static TapeOp withRightConst(ExprOp op) {
+    switch (op) {
+      case ExprOp::Add:
+        return TapeOp::AddC;
+      case ExprOp::Sub:
+        return TapeOp::SubC;
+      case ExprOp::Mul:
+        return TapeOp::MulC;
+      case ExprOp::Div:
+        return TapeOp::DivC;
+      default:
+        return TapeOp::PowC;
+    }
+  }
+
+  static TapeOp withLeftConst(ExprOp op) {
+    switch (op) {
+      case ExprOp::Add:
+        return TapeOp::AddC;
+      case ExprOp::Sub:
+        return TapeOp::CSub;
+      case ExprOp::Mul:
+        return TapeOp::MulC;
+      case ExprOp::Div:
+        return TapeOp::CDiv;
+      default:
+        return TapeOp::CPow;
+    }
+  }
+
+  static TapeOp unaryOp(ExprOp op) {
+    switch (op) {
+      case ExprOp::Neg:
+        return TapeOp::Neg;
+      case ExprOp::Sin:
+        return TapeOp::Sin;
+      case ExprOp::Cos:
+        return TapeOp::Cos;
+      case ExprOp::Tan:
+        return TapeOp::Tan;
+      case ExprOp::Exp:
+        return TapeOp::Exp;
+      case ExprOp::Log:
+        return TapeOp::Log;
+      case ExprOp::Log10:
+        return TapeOp::Log10;
+      case ExprOp::Log2:
+        return TapeOp::Log2;
+      case ExprOp::Sqrt:
+        return TapeOp::Sqrt;
+      case ExprOp::Abs:
+        return TapeOp::Abs;
+      case ExprOp::Asin:
+        return TapeOp::Asin;
+      case ExprOp::Acos:
+        return TapeOp::Acos;
+      case ExprOp::Atan:
+        return TapeOp::Atan;
+      case ExprOp::Sinh:
+        return TapeOp::Sinh;
+      case ExprOp::Cosh:
+        return TapeOp::Cosh;
+      case ExprOp::Tanh:
+        return TapeOp::Tanh;
+      default:
+        return TapeOp::Sign;
+    }
+  }
+
+  std::vector<std::uint32_t> free_;
+};
+
+template <class Fn>
+inline void mapUnary(double* d, const double* a, std::size_t n, Fn fn) {
+  for (std::size_t i = 0; i < n; ++i) {
+    d[i] = fn(a[i]);
+  }
+}
+
+MATAN_TAPE_KERNEL
+void runProgram(const TapeInstr* code, std::size_t count, double* regs, std::size_t n) {
+  constexpr std::size_t kStride = ExprTape::kBlock;
+  for (std::size_t k = 0; k < count; ++k) {
+    const TapeInstr& ins = code[k];
+    double* d = regs + ins.dst * kStride;
+    const double* a = regs + ins.a * kStride;
+    const double* b = regs + ins.b * kStride;
+    const double c = ins.imm;
+    switch (ins.op) {
+      case TapeOp::Const:
+        for (std::size_t i = 0; i < n; ++i) {
+          d[i] = c;
+        }
+        break;
+      case TapeOp::Neg:
+        for (std::size_t i = 0; i < n; ++i) {
+          d[i] = -a[i];
+        }
+        break;
+      case TapeOp::Add:
+        for (std::size_t i = 0; i < n; ++i) {
+          d[i] = a[i] + b[i];
+        }
+        break;
+      case TapeOp::Sub:
+        for (std::size_t i = 0; i < n; ++i) {
+          d[i] = a[i] - b[i];
+        }
+        break;
+      case TapeOp::Mul:
+        for (std::size_t i = 0; i < n; ++i) {
+          d[i] = a[i] * b[i];
+        }
+        break;
+      case TapeOp::Div:
+        for (std::size_t i = 0; i < n; ++i) {
+          d[i] = a[i] / b[i];
+        }
+        break;
+      case TapeOp::Pow:
+        for (std::size_t i = 0; i < n; ++i) {
+          d[i] = std::pow(a[i], b[i]);
+        }
+        break;
+      case TapeOp::AddC:
+        for (std::size_t i = 0; i < n; ++i) {
+          d[i] = a[i] + c;
+        }
+        break;
+      case TapeOp::SubC:
+        for (std::size_t i = 0; i < n; ++i) {
+          d[i] = a[i] - c;
+        }
+        break;
+      case TapeOp::CSub:
+        for (std::size_t i = 0; i < n; ++i) {
+          d[i] = c - a[i];
+        }
+        break;
+      case TapeOp::MulC:
+        for (std::size_t i = 0; i < n; ++i) {
+          d[i] = a[i] * c;
+        }
+        break;
+      case TapeOp::DivC:
+        for (std::size_t i = 0; i < n; ++i) {
+          d[i] = a[i] / c;
+        }
+        break;
+      case TapeOp::CDiv:
+        for (std::size_t i = 0; i < n; ++i) {
+          d[i] = c / a[i];
+        }
+        break;
+      case TapeOp::PowC:
+        for (std::size_t i = 0; i < n; ++i) {
+          d[i] = std::pow(a[i], c);
+        }
+        break;
+      case TapeOp::CPow:
+        for (std::size_t i = 0; i < n; ++i) {
+          d[i] = std::pow(c, a[i]);
+        }
+        break;
+      case TapeOp::Square:
+        for (std::size_t i = 0; i < n; ++i) {
+          d[i] = a[i] * a[i];
+        }
+        break;
+      case TapeOp::Sin:
+        mapUnary(d, a, n, [](double v) { return std::sin(v); });
+        break;
+      case TapeOp::Cos:
+        mapUnary(d, a, n, [](double v) { return std::cos(v); });
+        break;
+      case TapeOp::Tan:
+        mapUnary(d, a, n, [](double v) { return std::tan(v); });
+        break;
+      case TapeOp::Exp:
+        mapUnary(d, a, n, [](double v) { return std::exp(v); });
+        break;
+      case TapeOp::Log:
+        mapUnary(d, a, n, [](double v) { return std::log(v); });
+        break;
+      case TapeOp::Log10:
+        mapUnary(d, a, n, [](double v) { return std::log10(v); });
+        break;
+      case TapeOp::Log2:
+        mapUnary(d, a, n, [](double v) { return std::log2(v); });
+        break;
+      case TapeOp::Sqrt:
+        for (std::size_t i = 0; i < n; ++i) {
+          d[i] = std::sqrt(a[i]);
+        }
+        break;
+      case TapeOp::Abs:
+        for (std::size_t i = 0; i < n; ++i) {
+          d[i] = std::abs(a[i]);
+        }
+        break;
+      case TapeOp::Asin:
+        mapUnary(d, a, n, [](double v) { return std::asin(v); });
+        break;
+      case TapeOp::Acos:
+        mapUnary(d, a, n, [](double v) { return std::acos(v); });
+        break;
+      case TapeOp::Atan:
+        mapUnary(d, a, n, [](double v) { return std::atan(v); });
+        break;
+      case TapeOp::Sinh:
+        mapUnary(d, a, n, [](double v) { return std::sinh(v); });
+        break;
+      case TapeOp::Cosh:
+        mapUnary(d, a, n, [](double v) { return std::cosh(v); });
+        break;
+      case TapeOp::Tanh:
+        mapUnary(d, a, n, [](double v) { return std::tanh(v); });
+        break;
+      case TapeOp::Sign:
+        for (std::size_t i = 0; i < n; ++i) {
+          d[i] = a[i] > 0.0 ? 1.0 : (a[i] < 0.0 ? -1.0 : 0.0);
+        }
+        break;
+    }
+  }
+}
+
+// Value, first and second derivative of a one-operand instruction at u.
+struct UnaryJet {
+  double g = 0.0;
+  double g1 = 0.0;
+  double g2 = 0.0;
+};
+
+UnaryJet unaryJet(TapeOp op, double u, double c) {
+  switch (op) {
+    case TapeOp::Neg:
+      return {-u, -1.0, 0.0};
+    case TapeOp::AddC:
+      return {u + c, 1.0, 0.0};
+    case TapeOp::SubC:
+      return {u - c, 1.0, 0.0};
+    case TapeOp::CSub:
+      return {c - u, -1.0, 0.0};
+    case TapeOp::MulC:
+      return {u * c, c, 0.0};
+    case TapeOp::DivC:
+      return {u / c, 1.0 / c, 0.0};
+    case TapeOp::CDiv: {
+      double g = c / u;
+      return {g, -g / u, 2.0 * g / (u * u)};
+    }
+    case TapeOp::PowC:
+      return {std::pow(u, c), c * std::pow(u, c - 1.0), c * (c - 1.0) * std::pow(u, c - 2.0)};
+    case TapeOp::CPow: {
+      double g = std::pow(c, u);
+      double lc = std::log(c);
+      return {g, g * lc, g * lc * lc};
+    }
+    case TapeOp::Square:
+      return {u * u, 2.0 * u, 2.0};
+    case TapeOp::Sin: {
+      double s = std::sin(u);
+      return {s, std::cos(u), -s};
+    }
+    case TapeOp::Cos: {
+      double co = std::cos(u);
+      return {co, -std::sin(u), -co};
+    }
+    case TapeOp::Tan: {
+      double t = std::tan(u);
+      double sec2 = 1.0 + t * t;
+      return {t, sec2, 2.0 * t * sec2};
+    }
+    case TapeOp::Exp: {
+      double e = std::exp(u);
+      return {e, e, e};
+    }
+    case TapeOp::Log:
+      return {std::log(u), 1.0 / u, -1.0 / (u * u)};
+    case TapeOp::Log10: {
+      double k = 1.0 / std::log(10.0);
+      return {std::log10(u), k / u, -k / (u * u)};
+    }
+    case TapeOp::Log2: {
+      double k = 1.0 / std::log(2.0);
+      return {std::log2(u), k / u, -k / (u * u)};
+    }
+    case TapeOp::Sqrt: {
+      double r = std::sqrt(u);
+      return {r, 0.5 / r, -0.25 / (r * u)};
+    }
+    case TapeOp::Abs:
+      return {std::abs(u), u > 0.0 ? 1.0 : (u < 0.0 ? -1.0 : 0.0), 0.0};
+    case TapeOp::Asin:
+    case TapeOp::Acos: {
+      double q = 1.0 - u * u;
+      double g1 = 1.0 / std::sqrt(q);
+      double g2 = u * g1 / q;
+      if (op == TapeOp::Asin) {
+        return {std::asin(u), g1, g2};
+      }
+      return {std::acos(u), -g1, -g2};
+    }
+    case TapeOp::Atan: {
+      double q = 1.0 / (1.0 + u * u);
+      return {std::atan(u), q, -2.0 * u * q * q};
+    }
+    case TapeOp::Sinh:
+      return {std::sinh(u), std::cosh(u), std::sinh(u)};
+    case TapeOp::Cosh:
+      return {std::cosh(u), std::sinh(u), std::cosh(u)};
+    case TapeOp::Tanh: {
+      double t = std::tanh(u);
+      double sech2 = 1.0 - t * t;
+      return {t, sech2, -2.0 * t * sech2};
+    }
+    case TapeOp::Sign:
+      return {u > 0.0 ? 1.0 : (u < 0.0 ? -1.0 : 0.0), 0.0, 0.0};
+    default:
+      return {u, 1.0, 0.0};
+  }
+}
+
+// Second-order forward-mode pass: every register carries (value, d/dx, d2/dx2). Operands are
+// read into locals before the store because the destination may reuse an operand register.
+void runJetProgram(const TapeInstr* code, std::size_t count, double* v, double* d1, double* d2,
+                   std::size_t n) {
+  constexpr std::size_t kStride = ExprTape::kBlock;
+  for (std::size_t k = 0; k < count; ++k) {
+    const TapeInstr& ins = code[k];
+    const std::size_t d = ins.dst * kStride;
+    const std::size_t a = ins.a * kStride;
+    const std::size_t b = ins.b * kStride;
+    switch (ins.op) {
+      case TapeOp::Const:
+        for (std::size_t i = 0; i < n; ++i) {
+          v[d + i] = ins.imm;
+          d1[d + i] = 0.0;
+          d2[d + i] = 0.0;
+        }
+        break;
+      case TapeOp::Add:
+      case TapeOp::Sub: {
+        double sign = ins.op == TapeOp::Add ? 1.0 : -1.0;
+        for (std::size_t i = 0; i < n; ++i) {
+          double x = v[a + i];
+          double y = v[b + i];
+          double x1 = d1[a + i];
+          double y1 = d1[b + i];
+          double x2 = d2[a + i];
+          double y2 = d2[b + i];
+          v[d + i] = ins.op == TapeOp::Add ? x + y : x - y;
+          d1[d + i] = x1 + sign * y1;
+          d2[d + i] = x2 + sign * y2;
+        }
+        break;
+      }
+      case TapeOp::Mul:
+        for (std::size_t i = 0; i < n; ++i) {
+          double x = v[a + i];
+          double y = v[b + i];
+          double x1 = d1[a + i];
+          double y1 = d1[b + i];
+          double x2 = d2[a + i];
+          double y2 = d2[b + i];
+          v[d + i] = x * y;
+          d1[d + i] = x1 * y + x * y1;
+          d2[d + i] = x2 * y + 2.0 * x1 * y1 + x * y2;
+        }
+        break;
+      case TapeOp::Div:
+        for (std::size_t i = 0; i < n; ++i) {
+          double x = v[a + i];
+          double y = v[b + i];
+          double x1 = d1[a + i];
+          double y1 = d1[b + i];
+          double x2 = d2[a + i];
+          double y2 = d2[b + i];
+          double q = x / y;
+          double q1 = (x1 - q * y1) / y;
+          v[d + i] = q;
+          d1[d + i] = q1;
+          d2[d + i] = (x2 - 2.0 * q1 * y1 - q * y2) / y;
+        }
+        break;
+      case TapeOp::Pow:
+        // x^y = exp(y * log(x)).
+        for (std::size_t i = 0; i < n; ++i) {
+          double x = v[a + i];
+          double y = v[b + i];
+          double x1 = d1[a + i];
+          double y1 = d1[b + i];
+          double x2 = d2[a + i];
+          double y2 = d2[b + i];
+          double p = std::pow(x, y);
+          double l = std::log(x);
+          double l1 = x1 / x;
+          double l2 = (x2 * x - x1 * x1) / (x * x);
+          double w1 = y1 * l + y * l1;
+          double w2 = y2 * l + 2.0 * y1 * l1 + y * l2;
+          v[d + i] = p;
+          d1[d + i] = p * w1;
+          d2[d + i] = p * (w2 + w1 * w1);
+        }
+        break;
+      default:
+        for (std::size_t i = 0; i < n; ++i) {
+          double u1 = d1[a + i];
+          double u2 = d2[a + i];
+          UnaryJet j = unaryJet(ins.op, v[a + i], ins.imm);
+          v[d + i] = j.g;
+          d1[d + i] = j.g1 * u1;
+          d2[d + i] = j.g2 * u1 * u1 + j.g1 * u2;
+        }
+        break;
+    }
+  }
+}
+
+// Interval arithmetic with outward rounding. Results of +, -, *, / and sqrt are widened by one
+// ulp; libm functions, which are accurate to within an ulp but not correctly rounded, by two.
+// Domains are clipped the way eval() fails: points where an operation is not finite are left
+// out, and an operation undefined on its whole operand yields the empty interval (lo > hi).
+constexpr double kInf = std::numeric_limits<double>::infinity();
+constexpr double kPi = 3.14159265358979323846;
+
+Interval emptyInterval() {
+  return {kInf, -kInf};
+}
+
+Interval entireInterval() {
+  return {-kInf, kInf};
+}
+
+double down(double v, int ulps) {
+  for (int i = 0; i < ulps && std::isfinite(v); ++i) {
+    v = std::nextafter(v, -kInf);
+  }
+  return v;
+}
+
+double up(double v, int ulps) {
+  for (int i = 0; i < ulps && std::isfinite(v); ++i) {
+    v = std::nextafter(v, kInf);
+  }
+  return v;
+}
+
+Interval widen(double lo, double hi, int ulps) {
+  lo = std::isnan(lo) ? -kInf : down(lo, ulps);
+  hi = std::isnan(hi) ? kInf : up(hi, ulps);
+  return {lo, hi};
+}
+
+// Range of a monotone g over x; decreasing g swaps the ends.
+template <class Fn>
+Interval monotone(const Interval& x, bool increasing, int ulps, Fn g) {
+  double l = g(x.lo);
+  double h = g(x.hi);
+  return increasing ? widen(l, h, ulps) : widen(h, l, ulps);
+}
+
+// Range of a g that decreases up to 0 and increases after it (x^2, cosh, |x|, x^even).
+template <class Fn>
+Interval valley(const Interval& x, int ulps, Fn g) {
+  if (x.lo >= 0.0) {
+    return monotone(x, true, ulps, g);
+  }
+  if (x.hi <= 0.0) {
+    return monotone(x, false, ulps, g);
+  }
+  // g(0) is exact for every caller, so the minimum needs no widening.
+  Interval r = widen(g(0.0), std::max(g(x.lo), g(x.hi)), ulps);
+  r.lo = g(0.0);
+  return r;
+}
+
+// Whether phase + k * period lies in x for some integer k, erring towards true.
+bool hitsPeriodic(const Interval& x, double phase, double period) {
+  double slack = 1e-9 * (1.0 + std::fabs(x.lo) + std::fabs(x.hi));
+  double k = std::ceil((x.lo - slack - phase) / period);
+  return phase + k * period <= x.hi + slack;
+}
+
+Interval iAdd(const Interval& a, const Interval& b) {
+  return widen(a.lo + b.lo, a.hi + b.hi, 1);
+}
+
+Interval iSub(const Interval& a, const Interval& b) {
+  return widen(a.lo - b.hi, a.hi - b.lo, 1);
+}
+
+// A zero bound times an infinite one is 0: the infinity is a bound, never a value.
+double boundProduct(double u, double v) {
+  return u == 0.0 || v == 0.0 ? 0.0 : u * v;
+}
+
+Interval iMul(const Interval& a, const Interval& b) {
+  double p[] = {boundProduct(a.lo, b.lo), boundProduct(a.lo, b.hi), boundProduct(a.hi, b.lo),
+                boundProduct(a.hi, b.hi)};
+  return widen(*std::min_element(p, p + 4), *std::max_element(p, p + 4), 1);
+}
+
+Interval iDiv(const Interval& a, const Interval& b) {
+  if (b.lo == 0.0 && b.hi == 0.0) {
+    return emptyInterval();
+  }
+  if (b.lo < 0.0 && b.hi > 0.0) {
+    return entireInterval();
+  }
+  // A divisor touching 0 from one side only leaves that side unbounded.
+  if (b.lo == 0.0 || b.hi == 0.0) {
+    bool positive = b.lo == 0.0;
+    double edge = positive ? b.hi : b.lo;
+    if (a.lo >= 0.0) {
+      return positive ? widen(a.lo / edge, kInf, 1) : widen(-kInf, a.lo / edge, 1);
+    }
+    if (a.hi <= 0.0) {
+      return positive ? widen(-kInf, a.hi / edge, 1) : widen(a.hi / edge, kInf, 1);
+    }
+    return entireInterval();
+  }
+  double q[] = {a.lo / b.lo, a.lo / b.hi, a.hi / b.lo, a.hi / b.hi};
+  for (double v : q) {
+    if (std::isnan(v)) {
+      return entireInterval();
+    }
+  }
+  return widen(*std::min_element(q, q + 4), *std::max_element(q, q + 4), 1);
+}
+
+Interval iLog(const Interval& x, double (*g)(double)) {
+  if (x.hi <= 0.0) {
+    return emptyInterval();
+  }
+  return widen(x.lo <= 0.0 ? -kInf : g(x.lo), g(x.hi), 2);
+}
+
+Interval iSin(const Interval& x) {
+  if (!std::isfinite(x.lo) || !std::isfinite(x.hi) || x.hi - x.lo >= 2.0 * kPi) {
+    return {-1.0, 1.0};
+  }
+  double sl = std::sin(x.lo);
+  double sh = std::sin(x.hi);
+  double l = down(std::min(sl, sh), 2);
+  double h = up(std::max(sl, sh), 2);
+  if (hitsPeriodic(x, 0.5 * kPi, 2.0 * kPi)) {
+    h = 1.0;
+  }
+  if (hitsPeriodic(x, -0.5 * kPi, 2.0 * kPi)) {
+    l = -1.0;
+  }
+  return {std::max(l, -1.0), std::min(h, 1.0)};
+}
+
+Interval iCos(const Interval& x) {
+  if (!std::isfinite(x.lo) || !std::isfinite(x.hi) || x.hi - x.lo >= 2.0 * kPi) {
+    return {-1.0, 1.0};
+  }
+  double cl = std::cos(x.lo);
+  double ch = std::cos(x.hi);
+  double l = down(std::min(cl, ch), 2);
+  double h = up(std::max(cl, ch), 2);
+  if (hitsPeriodic(x, 0.0, 2.0 * kPi)) {
+    h = 1.0;
+  }
+  if (hitsPeriodic(x, kPi, 2.0 * kPi)) {
+    l = -1.0;
+  }
+  return {std::max(l, -1.0), std::min(h, 1.0)};
+}
+
+Interval iTan(const Interval& x) {
+  if (!std::isfinite(x.lo) || !std::isfinite(x.hi) || hitsPeriodic(x, 0.5 * kPi, kPi)) {
+    return entireInterval();
+  }
+  return monotone(x, true, 2, [](double v) { return std::tan(v); });
+}
+
+// x^c for a constant c, matching std::pow on every point where it is finite.
+Interval iPowC(const Interval& x, double c) {
+  if (c == 0.0) {
+    return {1.0, 1.0};
+  }
+  auto g = [c](double v) { return std::pow(v, c); };
+  if (c == std::trunc(c)) {
+    bool even = std::fmod(c, 2.0) == 0.0;
+    if (c > 0.0) {
+      return even ? valley(x, 2, g) : monotone(x, true, 2, g);
+    }
+    Interval magnitude = even ? valley(x, 2, [c](double v) { return std::pow(v, -c); })
+                              : monotone(x, true, 2, [c](double v) { return std::pow(v, -c); });
+    return iDiv({1.0, 1.0}, magnitude);
+  }
+  // Non-integer powers are only defined for x >= 0, and negative ones not at 0.
+  if (x.hi < 0.0 || (c < 0.0 && x.hi == 0.0)) {
+    return emptyInterval();
+  }
+  Interval d{std::max(x.lo, 0.0), x.hi};
+  if (c > 0.0) {
+    return monotone(d, true, 2, g);
+  }
+  return widen(g(d.hi), d.lo == 0.0 ? kInf : g(d.lo), 2);
+}
+
+// c^x for a constant c.
+Interval iCPow(const Interval& x, double c) {
+  if (c <= 0.0) {
+    return entireInterval();
+  }
+  if (c == 1.0) {
+    return {1.0, 1.0};
+  }
+  Interval r = monotone(x, c > 1.0, 2, [c](double v) { return std::pow(c, v); });
+  r.lo = std::max(r.lo, 0.0);
+  return r;
+}
+
+Interval iUnary(TapeOp op, const Interval& a, double c) {
+  switch (op) {
+    case TapeOp::Neg:
+      return {-a.hi, -a.lo};
+    case TapeOp::AddC:
+      return iAdd(a, {c, c});
+    case TapeOp::SubC:
+      return iSub(a, {c, c});
+    case TapeOp::CSub:
+      return iSub({c, c}, a);
+    case TapeOp::MulC:
+      return iMul(a, {c, c});
+    case TapeOp::DivC:
+      return iDiv(a, {c, c});
+    case TapeOp::CDiv:
+      return iDiv({c, c}, a);
+    case TapeOp::PowC:
+      return iPowC(a, c);
+    case TapeOp::CPow:
+      return iCPow(a, c);
+    case TapeOp::Square:
+      return valley(a, 1, [](double v) { return v * v; });
+    case TapeOp::Sin:
+      return iSin(a);
+    case TapeOp::Cos:
+      return iCos(a);
+    case TapeOp::Tan:
+      return iTan(a);
+    case TapeOp::Exp: {
+      Interval r = monotone(a, true, 2, [](double v) { return std::exp(v); });
+      r.lo = std::max(r.lo, 0.0);
+      return r;
+    }
+    case TapeOp::Log:
+      return iLog(a, [](double v) { return std::log(v); });
+    case TapeOp::Log10:
+      return iLog(a, [](double v) { return std::log10(v); });
+    case TapeOp::Log2:
+      return iLog(a, [](double v) { return std::log2(v); });
+    case TapeOp::Sqrt: {
+      if (a.hi < 0.0) {
+        return emptyInterval();
+      }
+      Interval r = monotone({std::max(a.lo, 0.0), a.hi}, true, 1,
+                            [](double v) { return std::sqrt(v); });
+      r.lo = std::max(r.lo, 0.0);
+      return r;
+    }
+    case TapeOp::Abs:
+      return valley(a, 0, [](double v) { return std::abs(v); });
+    case TapeOp::Asin:
+    case TapeOp::Acos: {
+      if (a.lo > 1.0 || a.hi < -1.0) {
+        return emptyInterval();
+      }
+      Interval d{std::max(a.lo, -1.0), std::min(a.hi, 1.0)};
+      if (op == TapeOp::Asin) {
+        return monotone(d, true, 2, [](double v) { return std::asin(v); });
+      }
+      return monotone(d, false, 2, [](double v) { return std::acos(v); });
+    }
+    case TapeOp::Atan:
+      return monotone(a, true, 2, [](double v) { return std::atan(v); });
+    case TapeOp::Sinh:
+      return monotone(a, true, 2, [](double v) { return std::sinh(v); });
+    case TapeOp::Cosh:
+      return valley(a, 2, [](double v) { return std::cosh(v); });
+    case TapeOp::Tanh:
+      return monotone(a, true, 2, [](double v) { return std::tanh(v); });
+    case TapeOp::Sign: {
+      auto s = [](double v) { return v > 0.0 ? 1.0 : (v < 0.0 ? -1.0 : 0.0); };
+      return {s(a.lo), s(a.hi)};
+    }
+    default:
+      return a;
+  }
+}
+
+Interval iBinary(TapeOp op, const Interval& a, const Interval& b) {
+  switch (op) {
+    case TapeOp::Add:
+      return iAdd(a, b);
+    case TapeOp::Sub:
+      return iSub(a, b);
+    case TapeOp::Mul:
+      return iMul(a, b);
+    case TapeOp::Div:
+      return iDiv(a, b);
+    default:
+      // x^y = exp(y * log(x)) where x > 0; negative bases are left unbounded.
+      if (a.lo <= 0.0) {
+        return entireInterval();
+      }
+      return iUnary(TapeOp::Exp, iMul(b, iLog(a, [](double v) { return std::log(v); })), 0.0);
+  }
+}
+
+// Whether op is finite on every point of its operands; otherwise the interval ops above drop the
+// bad points, and the result no longer says anything about f being continuous there.
+bool definedOn(TapeOp op, const Interval& a, const Interval& b, double c) {
+  switch (op) {
+    case TapeOp::Div:
+      return b.lo > 0.0 || b.hi < 0.0;
+    case TapeOp::DivC:
+      return c != 0.0;
+    case TapeOp::CDiv:
+      return a.lo > 0.0 || a.hi < 0.0;
+    case TapeOp::Pow:
+      return a.lo > 0.0;
+    case TapeOp::PowC:
+      if (c == std::trunc(c)) {
+        return c >= 0.0 || a.lo > 0.0 || a.hi < 0.0;
+      }
+      return c > 0.0 ? a.lo >= 0.0 : a.lo > 0.0;
+    case TapeOp::CPow:
+      return c > 0.0;
+    case TapeOp::Tan:
+      return std::isfinite(a.lo) && std::isfinite(a.hi) && !hitsPeriodic(a, 0.5 * kPi, kPi);
+    case TapeOp::Log:
+    case TapeOp::Log10:
+    case TapeOp::Log2:
+      return a.lo > 0.0;
+    case TapeOp::Sqrt:
+      return a.lo >= 0.0;
+    case TapeOp::Asin:
+    case TapeOp::Acos:
+      return a.lo >= -1.0 && a.hi <= 1.0;
+    default:
+      return true;
+  }
+}
+
+bool isBinary(TapeOp op) {
+  return op == TapeOp::Add || op == TapeOp::Sub || op == TapeOp::Mul || op == TapeOp::Div ||
+         op == TapeOp::Pow;
+}
+
+// Operands are read before the store because the destination may reuse an operand register.
+// x * x on one register is evaluated as a square, which keeps its lower bound at 0. partial[i]
+// (if given) is set when some operation had to leave points of lane i out.
+void runIntervalProgram(const TapeInstr* code, std::size_t count, Interval* regs, std::size_t n,
+                        std::uint8_t* partial) {
+  constexpr std::size_t kStride = ExprTape::kBlock;
+  for (std::size_t k = 0; k < count; ++k) {
+    const TapeInstr& ins = code[k];
+    Interval* d = regs + ins.dst * kStride;
+    const Interval* a = regs + ins.a * kStride;
+    const Interval* b = regs + ins.b * kStride;
+    bool binary = isBinary(ins.op);
+    for (std::size_t i = 0; i < n; ++i) {
+      if (ins.op == TapeOp::Const) {
+        d[i] = {ins.imm, ins.imm};
+        continue;
+      }
+      Interval u = a[i];
+      Interval v = binary ? b[i] : u;
+      if (partial && !definedOn(ins.op, u, v, ins.imm)) {
+        partial[i] = 1;
+      }
+      if (u.empty() || v.empty()) {
+        d[i] = emptyInterval();
+      } else if (ins.op == TapeOp::Mul && ins.a == ins.b) {
+        d[i] = iUnary(TapeOp::Square, u, 0.0);
+      } else {
+        d[i] = binary ? iBinary(ins.op, u, v) : iUnary(ins.op, u, ins.imm);
+      }
+    }
+  }
+}
+
+std::vector<Interval>& intervalScratch(std::size_t size) {
+  thread_local std::vector<Interval> regs;
+  if (regs.size() < size) {
+    regs.resize(size);
+  }
+  return regs;
+}
+
+std::vector<double>& scratch(std::size_t size) {
+  thread_local std::vector<double> regs;
+  if (regs.size() < size) {
+    regs.resize(size);
+  }
+  return regs;
+}
+
+}
+
+std::unique_ptr<const ExprTape> ExprTape::compile(const ExprNodePtr& root) {
+  if (!root) {
+    return nullptr;
+  }
+  Lowering lowering;
+  std::uint32_t result = lowering.emit(root);
+  std::unique_ptr<ExprTape> tape(new ExprTape());
+  tape->code_ = std::move(lowering.code);
+  tape->registers_ = lowering.next;
+  tape->result_ = result;
+  return tape;
+}
+
+void ExprTape::runBlock(double* regs, std::size_t n) const {
+  runProgram(code_.data(), code_.size(), regs, n);
+}
+
+double ExprTape::eval(double x) const {
+  double* regs = scratch(registers_ * kBlock).data();
+  regs[0] = x;
+  runBlock(regs, 1);
+  return regs[result_ * kBlock];
+}
+
+void ExprTape::eval(const double* xs, double* out, std::size_t n) const {
+  double* regs = scratch(registers_ * kBlock).data();
+  const double* res = regs + result_ * kBlock;
+  for (std::size_t start = 0; start < n; start += kBlock) {
+    std::size_t len = std::min(kBlock, n - start);
+    std::copy(xs + start, xs + start + len, regs);
+    runBlock(regs, len);
+    std::copy(res, res + len, out + start);
+  }
+}
+
+void ExprTape::evalGrid(double a, double h, std::size_t n, double* out) const {
+  double* regs = scratch(registers_ * kBlock).data();
+  const double* res = regs + result_ * kBlock;
+  for (std::size_t start = 0; start < n; start += kBlock) {
+    std::size_t len = std::min(kBlock, n - start);
+    for (std::size_t i = 0; i < len; ++i) {
+      regs[i] = a + static_cast<double>(start + i) * h;
+    }
+    runBlock(regs, len);
+    std::copy(res, res + len, out + start);
+  }
+}
+
+void ExprTape::evalJet(const double* xs, double* f, double* df, double* d2f, std::size_t n) const {
+  const std::size_t lanes = registers_ * kBlock;
+  double* v = scratch(3 * lanes).data();
+  double* d1 = v + lanes;
+  double* d2 = d1 + lanes;
+  const std::size_t res = result_ * kBlock;
+  for (std::size_t start = 0; start < n; start += kBlock) {
+    std::size_t len = std::min(kBlock, n - start);
+    std::copy(xs + start, xs + start + len, v);
+    std::fill(d1, d1 + len, 1.0);
+    std::fill(d2, d2 + len, 0.0);
+    runJetProgram(code_.data(), code_.size(), v, d1, d2, len);
+    std::copy(v + res, v + res + len, f + start);
+    std::copy(d1 + res, d1 + res + len, df + start);
+    if (d2f) {
+      std::copy(d2 + res, d2 + res + len, d2f + start);
+    }
+  }
+}
+
+void ExprTape::evalInterval(const Interval* xs, Interval* out, std::size_t n,
+                            std::uint8_t* partial) const {
+  Interval* regs = intervalScratch(registers_ * kBlock).data();
+  const Interval* res = regs + result_ * kBlock;
+  if (partial) {
+    std::fill(partial, partial + n, std::uint8_t{0});
+  }
+  for (std::size_t start = 0; start < n; start += kBlock) {
+    std::size_t len = std::min(kBlock, n - start);
+    std::copy(xs + start, xs + start + len, regs);
+    runIntervalProgram(code_.data(), code_.size(), regs, len, partial ? partial + start : nullptr);
+    std::copy(res, res + len, out + start);
+  }
+}
+
+bool ExprTape::continuous() const {
+  return std::none_of(code_.begin(), code_.end(),
+                      [](const TapeInstr& ins) { return ins.op == TapeOp::Sign; });
+}
+
+Interval centeredForm(const Interval& fm, const Interval& d, const Interval& x, double m) {
+  if (fm.empty() || d.empty() || x.empty()) {
+    return entireInterval();
+  }
+  return iAdd(fm, iMul(d, iSub(x, {m, m})));
+}
+
+Interval intersect(const Interval& a, const Interval& b) {
+  return {std::max(a.lo, b.lo), std::min(a.hi, b.hi)};
+}
+
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Expression.h"
+#include "ExprTree.h"
+
+namespace matan {
+
+enum class TapeOp : std::uint8_t {
+  Const,
+  Neg,
+  Add,
+  Sub,
+  Mul,
+  Div,
+  Pow,
+  AddC,
+  SubC,
+  CSub,
+  MulC,
+  DivC,
+  CDiv,
+  PowC,
+  CPow,
+  Square,
+  Sin,
+  Cos,
+  Tan,
+  Exp,
+  Log,
+  Log10,
+  Log2,
+  Sqrt,
+  Abs,
+  Asin,
+  Acos,
+  Atan,
+  Sinh,
+  Cosh,
+  Tanh,
+  Sign,
+};
+
+struct TapeInstr {
+  TapeOp op = TapeOp::Const;
+  std::uint32_t dst = 0;
+  std::uint32_t a = 0;
+  std::uint32_t b = 0;
+  double imm = 0.0;
+};
+
+// Flat register program lowered from an ExprNode tree. Register 0 holds x; every instruction
+// reads registers/immediates and writes one register. Evaluation runs the whole program over
+// blocks of kBlock x values, so each instruction becomes a tight loop the compiler vectorizes.
+class ExprTape {
+ public:
+  static constexpr std::size_t kBlock = 256;
+
+  static std::unique_ptr<const ExprTape> compile(const ExprNodePtr& root);
+
+  double eval(double x) const;
+  void eval(const double* xs, double* out, std::size_t n) const;
+  void evalGrid(double a, double h, std::size_t n, double* out) const;
+  // Forward-mode pass returning f, f' and (if d2f is not null) f'' at every point.
+  void evalJet(const double* xs, double* f, double* df, double* d2f, std::size_t n) const;
+  // Interval pass: out[i] encloses the program over xs[i]; see Expression::evalInterval.
+  // partial[i] (if not null) is set to 1 where some operation is undefined on part of xs[i].
+  void evalInterval(const Interval* xs, Interval* out, std::size_t n,
+                    std::uint8_t* partial = nullptr) const;
+  // False when the program contains a jump (sign), so bounds on f' say nothing about f.
+  bool continuous() const;
+
+  std::size_t registers() const {
+    return registers_;
+  }
+
+ private:
+  ExprTape() = default;
+  void runBlock(double* regs, std::size_t n) const;
+
+  std::vector<TapeInstr> code_;
+  std::size_t registers_ = 1;
+  std::uint32_t result_ = 0;
+};
+
+// Mean-value enclosure fm + d * (x - m) of f over x, from enclosures fm of f(m) and d of f' over
+// x. Only valid where f is continuous on x.
+Interval centeredForm(const Interval& fm, const Interval& d, const Interval& x, double m);
+
+Interval intersect(const Interval& a, const Interval& b);
+
+}
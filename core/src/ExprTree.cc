@@ -0,0 +1,498 @@
+#include "ExprTree.h"
+
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <utility>
+
+namespace matan {
+
+namespace {
+
+struct FuncName {
+  const char* name;
+  ExprOp op;
+};
+
+constexpr FuncName kFunctions[] = {
+    {"sin", ExprOp::Sin},   {"cos", ExprOp::Cos},     {"tan", ExprOp::Tan},
+    {"exp", ExprOp::Exp},   {"log", ExprOp::Log},     {"log10", ExprOp::Log10},
+    {"log2", ExprOp::Log2}, {"sqrt", ExprOp::Sqrt},   {"abs", ExprOp::Abs},
+    {"asin", ExprOp::Asin}, {"acos", ExprOp::Acos},   {"atan", ExprOp::Atan},
+    {"sinh", ExprOp::Sinh}, {"cosh", ExprOp::Cosh},   {"tanh", ExprOp::Tanh},
+    {"sgn", ExprOp::Sign},
+};
+
+bool isConst(const ExprNodePtr& node, double value) {
+  return node->op == ExprOp::Const && node->value == value;
+}
+
+class Parser {
+ public:
+  explicit Parser(const std::string& src) : src_(src) {}
+
+  ExprNodePtr parse() {
+    ExprNodePtr root = parseSum();
+    skipSpace();
+    if (!ok_ || pos_ != src_.size()) {
+      return nullptr;
+    }
+    return root;
+  }
+
+ private:
+  void skipSpace() {
+    while (pos_ < src_.size() && std::isspace(static_cast<unsigned char>(src_[pos_]))) {
+      ++pos_;
+    }
+  }
+
+  char peek() {
+    skipSpace();
+    return pos_ < src_.size() ? src_[pos_] : '\0';
+  }
+
+  bool accept(char c) {
+    if (peek() == c) {
+      ++pos_;
+      return true;
+    }
+    return false;
+  }
+
+  ExprNodePtr fail() {
+    ok_ = false;
+    return makeConst(0.0);
+  }
+
+  bool startsOperand() {
+    char c = peek();
+    return c == '(' || c == '.' || std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+  }
+
+  ExprNodePtr parseSum() {
+    ExprNodePtr lhs = parseProduct();
+    while (ok_) {
+      if (accept('+')) {
+        lhs = makeBinary(ExprOp::Add, lhs, parseProduct());
+      } else if (accept('-')) {
+        lhs = makeBinary(ExprOp::Sub, lhs, parseProduct());
+      } else {
+        break;
+      }
+    }
+    return lhs;
+  }
+
+  ExprNodePtr parseProduct() {
+    ExprNodePtr lhs = parseFactor();
+    while (ok_) {
+      if (accept('*')) {
+        lhs = makeBinary(ExprOp::Mul, lhs, parseFactor());
+      } else if (accept('/')) {
+        lhs = makeBinary(ExprOp::Div, lhs, parseFactor());
+      } else if (startsOperand()) {
+        // exprtk accepts implicit multiplication such as "2x" or "3sin(x)".
+        lhs = makeBinary(ExprOp::Mul, lhs, parseFactor());
+      } else {
+        break;
+      }
+    }
+    return lhs;
+  }
+
+  ExprNodePtr parseFactor() {
+    if (accept('-')) {
+      return makeUnary(ExprOp::Neg, parseFactor());
+    }
+    if (accept('+')) {
+      return parseFactor();
+    }
+    ExprNodePtr base = parsePrimary();
+    if (ok_ && accept('^')) {
+      return makeBinary(ExprOp::Pow, base, parseFactor());
+    }
+    return base;
+  }
+
+  ExprNodePtr parsePrimary() {
+    char c = peek();
+    if (c == '(') {
+      ++pos_;
+      ExprNodePtr inner = parseSum();
+      if (!accept(')')) {
+        return fail();
+      }
+      return inner;
+    }
+    if (std::isdigit(static_cast<unsigned char>(c)) || c == '.') {
+      return parseNumber();
+    }
+    if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+      return parseIdentifier();
+    }
+    return fail();
+  }
+
+  ExprNodePtr parseNumber() {
+    std::size_t start = pos_;
+    while (pos_ < src_.size() &&
+           (std::isdigit(static_cast<unsigned char>(src_[pos_])) || src_[pos_] == '.')) {
+      ++pos_;
+    }
+    if (pos_ < src_.size() && (src_[pos_] == 'e' || src_[pos_] == 'E')) {
+      std::size_t exp = pos_ + 1;
+      if (exp < src_.size() && (src_[exp] == '+' || src_[exp] == '-')) {
+        ++exp;
+      }
+      if (exp < src_.size() && std::isdigit(static_cast<unsigned char>(src_[exp]))) {
+        pos_ = exp;
+        while (pos_ < src_.size() && std::isdigit(static_cast<unsigned char>(src_[pos_]))) {
+          ++pos_;
+        }
+      }
+    }
+    std::string text = src_.substr(start, pos_ - start);
+    char* end = nullptr;
+    double value = std::strtod(text.c_str(), &end);
+    if (end != text.c_str() + text.size()) {
+      return fail();
+    }
+    return makeConst(value);
+  }
+
+  ExprNodePtr parseIdentifier() {
+    std::size_t start = pos_;
+    while (pos_ < src_.size() &&
+           (std::isalnum(static_cast<unsigned char>(src_[pos_])) || src_[pos_] == '_')) {
+      ++pos_;
+    }
+    std::string name = src_.substr(start, pos_ - start);
+    for (char& ch : name) {
+      ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+    }
+    if (name == "x") {
+      return makeVar();
+    }
+    if (name == "pow") {
+      if (!accept('(')) {
+        return fail();
+      }
+      ExprNodePtr base = parseSum();
+      if (!accept(',')) {
+        return fail();
+      }
+      ExprNodePtr exponent = parseSum();
+      if (!accept(')')) {
+        return fail();
+      }
+      return makeBinary(ExprOp::Pow, base, exponent);
+    }
+    for (const auto& fn : kFunctions) {
+      if (name == fn.name) {
+        if (!accept('(')) {
+          return fail();
+        }
+        ExprNodePtr arg = parseSum();
+        if (!accept(')')) {
+          return fail();
+        }
+        return makeUnary(fn.op, arg);
+      }
+    }
+    return fail();
+  }
+
+  const std::string& src_;
+  std::size_t pos_ = 0;
+  bool ok_ = true;
+};
+
+}
+
+ExprNodePtr parseExprTree(const std::string& src) {
+  return Parser(src).parse();
+}
+
+bool isUnaryOp(ExprOp op) {
+  switch (op) {
+    case ExprOp::Const:
+    case ExprOp::Var:
+    case ExprOp::Add:
+    case ExprOp::Sub:
+    case ExprOp::Mul:
+    case ExprOp::Div:
+    case ExprOp::Pow:
+      return false;
+    default:
+      return true;
+  }
+}
+
+double applyUnaryOp(ExprOp op, double v) {
+  switch (op) {
+    case ExprOp::Neg:
+      return -v;
+    case ExprOp::Sin:
+      return std::sin(v);
+    case ExprOp::Cos:
+      return std::cos(v);
+    case ExprOp::Tan:
+      return std::tan(v);
+    case ExprOp::Exp:
+      return std::exp(v);
+    case ExprOp::Log:
+      return std::log(v);
+    case ExprOp::Log10:
+      return std::log10(v);
+    case ExprOp::Log2:
+      return std::log2(v);
+    case ExprOp::Sqrt:
+      return std::sqrt(v);
+    case ExprOp::Abs:
+      return std::abs(v);
+    case ExprOp::Asin:
+      return std::asin(v);
+    case ExprOp::Acos:
+      return std::acos(v);
+    case ExprOp::Atan:
+      return std::atan(v);
+    case ExprOp::Sinh:
+      return std::sinh(v);
+    case ExprOp::Cosh:
+      return std::cosh(v);
+    case ExprOp::Tanh:
+      return std::tanh(v);
+    case ExprOp::Sign:
+      return v > 0.0 ? 1.0 : (v < 0.0 ? -1.0 : 0.0);
+    default:
+      return v;
+  }
+}
+
+double applyBinaryOp(ExprOp op, double a, double b) {
+  switch (op) {
+    case ExprOp::Add:
+      return a + b;
+    case ExprOp::Sub:
+      return a - b;
+    case ExprOp::Mul:
+      return a * b;
+    case ExprOp::Div:
+      return a / b;
+    case ExprOp::Pow:
+      return b == 2.0 ? a * a : std::pow(a, b);
+    default:
+      return a;
+  }
+}
+
+namespace {
+
+ExprNodePtr add(ExprNodePtr a, ExprNodePtr b) {
+  return makeBinary(ExprOp::Add, std::move(a), std::move(b));
+}
+
+ExprNodePtr sub(ExprNodePtr a, ExprNodePtr b) {
+  return makeBinary(ExprOp::Sub, std::move(a), std::move(b));
+}
+
+ExprNodePtr mul(ExprNodePtr a, ExprNodePtr b) {
+  return makeBinary(ExprOp::Mul, std::move(a), std::move(b));
+}
+
+ExprNodePtr div(ExprNodePtr a, ExprNodePtr b) {
+  return makeBinary(ExprOp::Div, std::move(a), std::move(b));
+}
+
+ExprNodePtr square(ExprNodePtr a) {
+  return makeBinary(ExprOp::Pow, std::move(a), makeConst(2.0));
+}
+
+}
+
+// A derivative term with a zero factor is dropped here rather than in makeBinary: the other
+// factor is a subexpression of f, so the term is 0 wherever f itself is finite.
+ExprNodePtr differentiateTree(const ExprNodePtr& node) {
+  const ExprNodePtr& u = node->lhs;
+  const ExprNodePtr& v = node->rhs;
+  switch (node->op) {
+    case ExprOp::Const:
+    case ExprOp::Sign:
+      return makeConst(0.0);
+    case ExprOp::Var:
+      return makeConst(1.0);
+    default:
+      break;
+  }
+  ExprNodePtr du = differentiateTree(u);
+  if (isConst(du, 0.0) && isUnaryOp(node->op)) {
+    return du;
+  }
+  switch (node->op) {
+    case ExprOp::Neg:
+      return makeUnary(ExprOp::Neg, du);
+    case ExprOp::Add:
+      return add(du, differentiateTree(v));
+    case ExprOp::Sub:
+      return sub(du, differentiateTree(v));
+    case ExprOp::Mul: {
+      ExprNodePtr dv = differentiateTree(v);
+      if (isConst(du, 0.0)) {
+        return isConst(dv, 0.0) ? du : mul(u, dv);
+      }
+      if (isConst(dv, 0.0)) {
+        return mul(du, v);
+      }
+      return add(mul(du, v), mul(u, dv));
+    }
+    case ExprOp::Div: {
+      ExprNodePtr dv = differentiateTree(v);
+      if (isConst(dv, 0.0)) {
+        return isConst(du, 0.0) ? du : div(du, v);
+      }
+      if (isConst(du, 0.0)) {
+        return div(makeUnary(ExprOp::Neg, mul(u, dv)), square(v));
+      }
+      return div(sub(mul(du, v), mul(u, dv)), square(v));
+    }
+    case ExprOp::Pow: {
+      if (v->op == ExprOp::Const) {
+        // pow(x, 0) is 1 even at x = NaN or inf.
+        if (isConst(du, 0.0) || v->value == 0.0) {
+          return makeConst(0.0);
+        }
+        ExprNodePtr power = makeBinary(ExprOp::Pow, u, makeConst(v->value - 1.0));
+        return mul(mul(makeConst(v->value), power), du);
+      }
+      ExprNodePtr dv = differentiateTree(v);
+      if (u->op == ExprOp::Const) {
+        return isConst(dv, 0.0) ? dv : mul(mul(node, makeConst(std::log(u->value))), dv);
+      }
+      if (isConst(dv, 0.0)) {
+        return isConst(du, 0.0) ? du : mul(node, div(mul(v, du), u));
+      }
+      if (isConst(du, 0.0)) {
+        return mul(node, mul(dv, makeUnary(ExprOp::Log, u)));
+      }
+      return mul(node, add(mul(dv, makeUnary(ExprOp::Log, u)), div(mul(v, du), u)));
+    }
+    case ExprOp::Sin:
+      return mul(makeUnary(ExprOp::Cos, u), du);
+    case ExprOp::Cos:
+      return makeUnary(ExprOp::Neg, mul(makeUnary(ExprOp::Sin, u), du));
+    case ExprOp::Tan:
+      return div(du, square(makeUnary(ExprOp::Cos, u)));
+    case ExprOp::Exp:
+      return mul(node, du);
+    case ExprOp::Log:
+      return div(du, u);
+    case ExprOp::Log10:
+      return div(du, mul(u, makeConst(std::log(10.0))));
+    case ExprOp::Log2:
+      return div(du, mul(u, makeConst(std::log(2.0))));
+    case ExprOp::Sqrt:
+      return div(du, mul(makeConst(2.0), node));
+    case ExprOp::Abs:
+      return mul(makeUnary(ExprOp::Sign, u), du);
+    case ExprOp::Asin:
+      return div(du, makeUnary(ExprOp::Sqrt, sub(makeConst(1.0), square(u))));
+    case ExprOp::Acos:
+      return makeUnary(ExprOp::Neg,
+                       div(du, makeUnary(ExprOp::Sqrt, sub(makeConst(1.0), square(u)))));
+    case ExprOp::Atan:
+      return div(du, add(makeConst(1.0), square(u)));
+    case ExprOp::Sinh:
+      return mul(makeUnary(ExprOp::Cosh, u), du);
+    case ExprOp::Cosh:
+      return mul(makeUnary(ExprOp::Sinh, u), du);
+    case ExprOp::Tanh:
+      return div(du, square(makeUnary(ExprOp::Cosh, u)));
+    default:
+      return makeConst(0.0);
+  }
+}
+
+ExprNodePtr makeConst(double value) {
+  auto node = std::make_shared<ExprNode>();
+  node->op = ExprOp::Const;
+  node->value = value;
+  return node;
+}
+
+ExprNodePtr makeVar() {
+  auto node = std::make_shared<ExprNode>();
+  node->op = ExprOp::Var;
+  return node;
+}
+
+ExprNodePtr makeUnary(ExprOp op, ExprNodePtr arg) {
+  if (arg->op == ExprOp::Const) {
+    return makeConst(applyUnaryOp(op, arg->value));
+  }
+  if (op == ExprOp::Neg && arg->op == ExprOp::Neg) {
+    return arg->lhs;
+  }
+  auto node = std::make_shared<ExprNode>();
+  node->op = op;
+  node->lhs = std::move(arg);
+  return node;
+}
+
+ExprNodePtr makeBinary(ExprOp op, ExprNodePtr lhs, ExprNodePtr rhs) {
+  if (lhs->op == ExprOp::Const && rhs->op == ExprOp::Const) {
+    return makeConst(applyBinaryOp(op, lhs->value, rhs->value));
+  }
+  switch (op) {
+    case ExprOp::Add:
+      if (isConst(lhs, 0.0)) {
+        return rhs;
+      }
+      if (isConst(rhs, 0.0)) {
+        return lhs;
+      }
+      break;
+    case ExprOp::Sub:
+      if (isConst(rhs, 0.0)) {
+        return lhs;
+      }
+      if (isConst(lhs, 0.0)) {
+        return makeUnary(ExprOp::Neg, rhs);
+      }
+      break;
+    case ExprOp::Mul:
+      // x * 0 is not folded: it is NaN where x is NaN or infinite, and exprtk keeps that.
+      if (isConst(lhs, 1.0)) {
+        return rhs;
+      }
+      if (isConst(rhs, 1.0)) {
+        return lhs;
+      }
+      if (isConst(lhs, -1.0)) {
+        return makeUnary(ExprOp::Neg, rhs);
+      }
+      if (isConst(rhs, -1.0)) {
+        return makeUnary(ExprOp::Neg, lhs);
+      }
+      break;
+    case ExprOp::Div:
+      if (isConst(rhs, 1.0)) {
+        return lhs;
+      }
+      break;
+    case ExprOp::Pow:
+      if (isConst(rhs, 1.0)) {
+        return lhs;
+      }
+      break;
+    default:
+      break;
+  }
+  auto node = std::make_shared<ExprNode>();
+  node->op = op;
+  node->lhs = std::move(lhs);
+  node->rhs = std::move(rhs);
+  return node;
+}
+
+}
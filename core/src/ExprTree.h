@@ -0,0 +1,62 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+namespace matan {
+
+enum class ExprOp {
+  Const,
+  Var,
+  Neg,
+  Add,
+  Sub,
+  Mul,
+  Div,
+  Pow,
+  Sin,
+  Cos,
+  Tan,
+  Exp,
+  Log,
+  Log10,
+  Log2,
+  Sqrt,
+  Abs,
+  Asin,
+  Acos,
+  Atan,
+  Sinh,
+  Cosh,
+  Tanh,
+  Sign,
+};
+
+struct ExprNode;
+using ExprNodePtr = std::shared_ptr<const ExprNode>;
+
+struct ExprNode {
+  ExprOp op = ExprOp::Const;
+  double value = 0.0;
+  ExprNodePtr lhs;
+  ExprNodePtr rhs;
+};
+
+// Parses the subset of exprtk syntax the tape backend understands. Returns nullptr for anything
+// outside it; the caller then keeps evaluating through exprtk.
+ExprNodePtr parseExprTree(const std::string& src);
+
+bool isUnaryOp(ExprOp op);
+double applyUnaryOp(ExprOp op, double v);
+double applyBinaryOp(ExprOp op, double a, double b);
+
+// Exact d/dx of the tree, simplified through the folding constructors below.
+ExprNodePtr differentiateTree(const ExprNodePtr& node);
+
+// Node constructors fold constant subtrees and drop neutral elements (x + 0, x * 1, x * 0).
+ExprNodePtr makeConst(double value);
+ExprNodePtr makeVar();
+ExprNodePtr makeUnary(ExprOp op, ExprNodePtr arg);
+ExprNodePtr makeBinary(ExprOp op, ExprNodePtr lhs, ExprNodePtr rhs);
+
+}
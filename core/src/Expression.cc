@@ -2,73 +2,281 @@
 
 #include <exprtk.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <cctype>
 #include <cmath>
+#include <list>
+#include <mutex>
 #include <stdexcept>
+#include <unordered_map>
 #include <utility>
+#include <vector>
+
+#include "ExprTape.h"
+#include "ExprTree.h"
 
 namespace matan {
 
-Expression::Expression(std::string expr)
-    : expr_(std::move(expr)), parser_(std::make_unique<exprtk::parser<double>>()) {
-  InitParser();
+// exprtk binds the variable by address, so one exprtk expression can only be evaluated by one
+// thread at a time. Every thread that needs the exprtk path gets its own ExprtkState.
+struct ExprtkState {
+  explicit ExprtkState(const std::string& source) {
+    symbols.add_variable("x", x);
+    expr.register_symbol_table(symbols);
+    exprtk::parser<double> parser;
+    if (!parser.compile(source, expr)) {
+      throw std::runtime_error("exprtk parse error");
+    }
+  }
+  ExprtkState(const ExprtkState&) = delete;
+  ExprtkState& operator=(const ExprtkState&) = delete;
+
+  double value(double at) {
+    x = at;
+    return expr.value();
+  }
+
+  double derivative(double at) {
+    x = at;
+    return exprtk::derivative(expr, "x", std::max(1e-8, std::abs(at) * 1e-4 + 1e-6));
+  }
+
+  double secondDerivative(double at) {
+    x = at;
+    return exprtk::second_derivative(expr, "x", std::max(1e-5, std::abs(at) * 1e-3 + 1e-4));
+  }
+
+  double x = 0.0;
+  exprtk::symbol_table<double> symbols;
+  exprtk::expression<double> expr;
+};
+
+// Immutable result of compiling one source string, shared by every Expression handle created
+// from equivalent text and safe to evaluate from any number of threads. The tapes keep their
+// scratch registers per thread; the exprtk fallback is compiled lazily once per thread.
+struct CompiledExpression {
+  explicit CompiledExpression(const std::string& source);
+  CompiledExpression(const CompiledExpression&) = delete;
+  CompiledExpression& operator=(const CompiledExpression&) = delete;
+
+  ExprtkState& exprtk() const;
+  bool tapeMatchesExprtk() const;
+  template <class Derivative>
+  bool derivativeMatchesExprtk(Derivative actual) const;
+
+  std::uint64_t id = 0;
+  std::string source;
+  std::unique_ptr<const ExprTape> tape;
+  std::unique_ptr<const ExprTape> derivative_tape;
+  // The forward-mode jet over `tape` passed the same check as derivative_tape; otherwise jets
+  // take f' and f'' from exprtk like derivative() does without a derivative tape.
+  bool jet = false;
+};
+
+namespace {
+
+constexpr std::size_t kMaxThreadStates = 64;
+
+std::uint64_t nextExpressionId() {
+  static std::atomic<std::uint64_t> counter{0};
+  return ++counter;
 }
 
-Expression::Expression(const Expression& other)
-    : expr_(other.expr_), parser_(std::make_unique<exprtk::parser<double>>()) {
-  InitParser();
 }
 
-Expression& Expression::operator=(const Expression& other) {
-  if (this != &other) {
-    expr_ = other.expr_;
-    x_ = 0.0;
-    parser_ = std::make_unique<exprtk::parser<double>>();
-    InitParser();
+// Keyed by id rather than address so that a new expression allocated at a recycled address
+// never picks up a stale state. A full thread evicts only its least recently used state, so the
+// returned reference stays valid until this thread compiles kMaxThreadStates other expressions;
+// callers must not hold it across a call that may compile one.
+ExprtkState& CompiledExpression::exprtk() const {
+  using Entry = std::pair<std::uint64_t, std::unique_ptr<ExprtkState>>;
+  thread_local std::list<Entry> entries;
+  thread_local std::unordered_map<std::uint64_t, std::list<Entry>::iterator> index;
+  auto it = index.find(id);
+  if (it != index.end()) {
+    entries.splice(entries.begin(), entries, it->second);
+    return *it->second->second;
   }
-  return *this;
+  entries.emplace_front(id, std::make_unique<ExprtkState>(source));
+  index[id] = entries.begin();
+  if (entries.size() > kMaxThreadStates) {
+    index.erase(entries.back().first);
+    entries.pop_back();
+  }
+  return *entries.front().second;
 }
 
-Expression::Expression(Expression&& other) noexcept
-    : expr_(std::move(other.expr_)), parser_(std::make_unique<exprtk::parser<double>>()) {
-  InitParser();
+CompiledExpression::CompiledExpression(const std::string& src)
+    : id(nextExpressionId()), source(src) {
+  exprtk();
+  ExprNodePtr tree = parseExprTree(source);
+  tape = ExprTape::compile(tree);
+  if (tape && !tapeMatchesExprtk()) {
+    tape.reset();
+  }
+  if (tape) {
+    derivative_tape = ExprTape::compile(differentiateTree(tree));
+    if (derivative_tape &&
+        !derivativeMatchesExprtk([&](double x) { return derivative_tape->eval(x); })) {
+      derivative_tape.reset();
+    }
+  }
+  if (derivative_tape) {
+    jet = derivativeMatchesExprtk([&](double x) {
+      double v = 0.0;
+      double d = 0.0;
+      tape->evalJet(&x, &v, &d, nullptr, 1);
+      return d;
+    });
+  }
 }
 
-Expression& Expression::operator=(Expression&& other) noexcept {
-  if (this != &other) {
-    expr_ = std::move(other.expr_);
-    x_ = 0.0;
-    parser_ = std::make_unique<exprtk::parser<double>>();
-    InitParser();
+// Not a bit-exact check: exprtk folds and reassociates constants on its own (10*x/3 runs as
+// x*(10/3)), so the two can differ in the last bits. The tape is accepted when every probe
+// agrees to 1e-12 relative and both sides agree on NaN and infinity.
+bool CompiledExpression::tapeMatchesExprtk() const {
+  constexpr double kProbes[] = {-3.7, -1.3, -0.45, 0.0, 0.3, 0.9, 1.7, 2.6, 5.1};
+  for (double probe : kProbes) {
+    double expected = exprtk().value(probe);
+    double actual = tape->eval(probe);
+    if (std::isnan(expected) || std::isnan(actual)) {
+      if (std::isnan(expected) != std::isnan(actual)) {
+        return false;
+      }
+      continue;
+    }
+    if (std::isinf(expected) || std::isinf(actual)) {
+      if (expected != actual) {
+        return false;
+      }
+      continue;
+    }
+    if (std::abs(expected - actual) > 1e-12 * std::max(1.0, std::abs(expected))) {
+      return false;
+    }
   }
-  return *this;
+  return true;
 }
 
-Expression::~Expression() = default;
+// exprtk's derivative is a finite-difference rule, so it only serves as a loose sanity check of
+// the symbolic one; points where either side is not finite are skipped.
+template <class Derivative>
+bool CompiledExpression::derivativeMatchesExprtk(Derivative derivative) const {
+  constexpr double kProbes[] = {-3.7, -1.3, -0.45, 0.3, 0.9, 1.7, 2.6, 5.1};
+  for (double probe : kProbes) {
+    double expected = exprtk().derivative(probe);
+    double actual = derivative(probe);
+    if (!std::isfinite(expected) || !std::isfinite(actual)) {
+      continue;
+    }
+    if (std::abs(expected - actual) > 1e-6 * std::max(1.0, std::abs(expected))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+namespace {
+
+constexpr std::size_t kCacheCapacity = 64;
+
+bool isWordChar(char c) {
+  return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '.';
+}
 
-void Expression::InitParser() {
-  symbol_table_.clear();
-  symbol_table_.add_variable("x", x_);
-  exprtk_expr_.register_symbol_table(symbol_table_);
-  bool ok = parser_->compile(expr_, exprtk_expr_);
-  if (!ok) {
-    throw std::runtime_error("exprtk parse error");
+// exprtk is case-insensitive and ignores whitespace except between two word characters, so
+// "X^2 + 1" and "x^2+1" share one entry while "2 3" and "23" stay distinct.
+std::string normalizeSource(const std::string& src) {
+  std::string out;
+  out.reserve(src.size());
+  bool pending_space = false;
+  for (char c : src) {
+    if (std::isspace(static_cast<unsigned char>(c))) {
+      pending_space = true;
+      continue;
+    }
+    if (pending_space && !out.empty() && isWordChar(out.back()) && isWordChar(c)) {
+      out.push_back(' ');
+    }
+    pending_space = false;
+    out.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(c))));
   }
+  return out;
+}
+
+// Process-wide LRU of compiled expressions. Compilation happens under the lock so that each
+// distinct source is parsed exactly once even when several threads ask for it together.
+class ExpressionCache {
+ public:
+  template <class Compile>
+  std::shared_ptr<const CompiledExpression> get(const std::string& key, Compile compile) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+      entries_.splice(entries_.begin(), entries_, it->second);
+      return it->second->second;
+    }
+    auto impl = compile();
+    entries_.emplace_front(key, impl);
+    index_[key] = entries_.begin();
+    if (entries_.size() > kCacheCapacity) {
+      index_.erase(entries_.back().first);
+      entries_.pop_back();
+    }
+    return impl;
+  }
+
+ private:
+  using Entry = std::pair<std::string, std::shared_ptr<const CompiledExpression>>;
+  std::mutex mutex_;
+  std::list<Entry> entries_;
+  std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+};
+
+ExpressionCache& expressionCache() {
+  static ExpressionCache cache;
+  return cache;
+}
+
+}
+
+Expression::Expression(std::string expr)
+    : impl_(expressionCache().get(normalizeSource(expr), [&] {
+        return std::make_shared<const CompiledExpression>(expr);
+      })) {}
+
+Expression::Expression(const Expression& other) = default;
+Expression& Expression::operator=(const Expression& other) = default;
+Expression::Expression(Expression&& other) noexcept = default;
+Expression& Expression::operator=(Expression&& other) noexcept = default;
+Expression::~Expression() = default;
+
+const std::string& Expression::source() const {
+  return impl_->source;
 }
 
 double Expression::eval(double x) const {
-  x_ = x;
-  double v = exprtk_expr_.value();
+  double v = 0.0;
+  if (impl_->tape) {
+    v = impl_->tape->eval(x);
+  } else {
+    v = impl_->exprtk().value(x);
+  }
   if (!std::isfinite(v)) {
-    throw std::runtime_error("Function is not finite at x=" + std::to_string(x_) +
+    throw std::runtime_error("Function is not finite at x=" + std::to_string(x) +
                              ". Adjust the interval to avoid poles/singularities.");
   }
   return v;
 }
 
 double Expression::derivative(double x) const {
-  x_ = x;
-  double d =
-      exprtk::derivative(exprtk_expr_, "x", std::max(1e-8, std::abs(x_) * 1e-4 + 1e-6));
+  double d = 0.0;
+  if (impl_->derivative_tape) {
+    d = impl_->derivative_tape->eval(x);
+  } else {
+    d = impl_->exprtk().derivative(x);
+  }
   if (!std::isfinite(d)) {
     throw std::runtime_error("Derivative is not finite at x=" + std::to_string(x) +
                              ". Adjust the interval to avoid poles/singularities.");
@@ -76,4 +284,178 @@ double Expression::derivative(double x) const {
   return d;
 }
 
+namespace {
+
+// v - v is NaN exactly when v is NaN or infinite, and unlike std::isfinite it vectorizes.
+template <class XAt>
+EvalStatus scanFinite(const double* v, std::size_t n, std::span<std::uint8_t> mask, XAt x_at) {
+  std::size_t bad = 0;
+  for (std::size_t i = 0; i < n; ++i) {
+    bad += (v[i] - v[i] != 0.0) ? 1 : 0;
+  }
+  if (!mask.empty()) {
+    for (std::size_t i = 0; i < n; ++i) {
+      mask[i] = (v[i] - v[i] != 0.0) ? 1 : 0;
+    }
+  }
+  EvalStatus status;
+  if (bad == 0) {
+    return status;
+  }
+  status.non_finite = bad;
+  for (std::size_t i = 0; i < n; ++i) {
+    if (!std::isfinite(v[i])) {
+      status.first_index = i;
+      status.first_x = x_at(i);
+      break;
+    }
+  }
+  return status;
+}
+
+void checkSizes(std::size_t n, std::size_t out, std::size_t mask) {
+  if (out < n || (mask != 0 && mask < n)) {
+    throw std::runtime_error("Expression batch: output span is too small");
+  }
+}
+
+}
+
+EvalStatus Expression::evalBatch(std::span<const double> xs, std::span<double> out,
+                                 std::span<std::uint8_t> mask) const {
+  checkSizes(xs.size(), out.size(), mask.size());
+  if (impl_->tape) {
+    impl_->tape->eval(xs.data(), out.data(), xs.size());
+  } else {
+    ExprtkState& state = impl_->exprtk();
+    for (std::size_t i = 0; i < xs.size(); ++i) {
+      out[i] = state.value(xs[i]);
+    }
+  }
+  return scanFinite(out.data(), xs.size(), mask, [&](std::size_t i) { return xs[i]; });
+}
+
+EvalStatus Expression::evalGrid(double a, double h, std::size_t n, std::span<double> out,
+                                std::span<std::uint8_t> mask) const {
+  checkSizes(n, out.size(), mask.size());
+  if (impl_->tape) {
+    impl_->tape->evalGrid(a, h, n, out.data());
+  } else {
+    ExprtkState& state = impl_->exprtk();
+    for (std::size_t i = 0; i < n; ++i) {
+      out[i] = state.value(a + static_cast<double>(i) * h);
+    }
+  }
+  return scanFinite(out.data(), n, mask,
+                    [&](std::size_t i) { return a + static_cast<double>(i) * h; });
+}
+
+EvalStatus Expression::derivativeBatch(std::span<const double> xs, std::span<double> out,
+                                       std::span<std::uint8_t> mask) const {
+  checkSizes(xs.size(), out.size(), mask.size());
+  if (impl_->derivative_tape) {
+    impl_->derivative_tape->eval(xs.data(), out.data(), xs.size());
+  } else {
+    ExprtkState& state = impl_->exprtk();
+    for (std::size_t i = 0; i < xs.size(); ++i) {
+      out[i] = state.derivative(xs[i]);
+    }
+  }
+  return scanFinite(out.data(), xs.size(), mask, [&](std::size_t i) { return xs[i]; });
+}
+
+Jet Expression::evalJet(double x) const {
+  Jet jet;
+  JetStatus status = evalJetBatch(std::span<const double>(&x, 1), std::span<double>(&jet.f, 1),
+                                  std::span<double>(&jet.df, 1), std::span<double>(&jet.d2f, 1));
+  requireFinite(status);
+  return jet;
+}
+
+JetStatus Expression::evalJetBatch(std::span<const double> xs, std::span<double> f,
+                                   std::span<double> df, std::span<double> d2f) const {
+  checkSizes(xs.size(), f.size(), 0);
+  checkSizes(xs.size(), df.size(), d2f.size());
+  if (impl_->jet) {
+    impl_->tape->evalJet(xs.data(), f.data(), df.data(), d2f.empty() ? nullptr : d2f.data(),
+                   xs.size());
+  } else {
+    if (impl_->tape) {
+      impl_->tape->eval(xs.data(), f.data(), xs.size());
+    }
+    ExprtkState& state = impl_->exprtk();
+    for (std::size_t i = 0; i < xs.size(); ++i) {
+      if (!impl_->tape) {
+        f[i] = state.value(xs[i]);
+      }
+      df[i] = state.derivative(xs[i]);
+      if (!d2f.empty()) {
+        d2f[i] = state.secondDerivative(xs[i]);
+      }
+    }
+  }
+  auto x_at = [&](std::size_t i) { return xs[i]; };
+  JetStatus status;
+  status.f = scanFinite(f.data(), xs.size(), {}, x_at);
+  status.df = scanFinite(df.data(), xs.size(), {}, x_at);
+  return status;
+}
+
+bool Expression::supportsIntervals() const {
+  return impl_->tape != nullptr;
+}
+
+Interval Expression::evalInterval(Interval x) const {
+  Interval out;
+  evalIntervalBatch(std::span<const Interval>(&x, 1), std::span<Interval>(&out, 1));
+  return out;
+}
+
+void Expression::evalIntervalBatch(std::span<const Interval> xs, std::span<Interval> out) const {
+  checkSizes(xs.size(), out.size(), 0);
+  if (!impl_->tape) {
+    throw std::runtime_error("Interval evaluation is not supported for this expression: " +
+                             impl_->source);
+  }
+  std::vector<std::uint8_t> partial(xs.size());
+  impl_->tape->evalInterval(xs.data(), out.data(), xs.size(), partial.data());
+  // The natural enclosure overestimates when x occurs several times; on a continuous f the
+  // centered form f(m) + f'(x) * (x - m) shrinks that error quadratically with the width. The
+  // mean value theorem needs f defined on all of x, so boxes with dropped points keep the former.
+  if (!impl_->derivative_tape || !impl_->tape->continuous()) {
+    return;
+  }
+  for (std::size_t i = 0; i < xs.size(); ++i) {
+    const Interval& x = xs[i];
+    if (partial[i] || out[i].empty() || !std::isfinite(x.lo) || !std::isfinite(x.hi)) {
+      continue;
+    }
+    double m = 0.5 * (x.lo + x.hi);
+    Interval point{m, m};
+    Interval fm;
+    Interval d;
+    impl_->tape->evalInterval(&point, &fm, 1);
+    impl_->derivative_tape->evalInterval(&x, &d, 1);
+    if (fm.empty() || d.empty() || !std::isfinite(d.lo) || !std::isfinite(d.hi)) {
+      continue;
+    }
+    Interval narrowed = intersect(out[i], centeredForm(fm, d, x, m));
+    if (!narrowed.empty()) {
+      out[i] = narrowed;
+    }
+  }
+}
+
+void requireFinite(const EvalStatus& status, const std::string& what) {
+  if (!status.ok()) {
+    throw std::runtime_error(what + " is not finite at x=" + std::to_string(status.first_x) +
+                             ". Adjust the interval to avoid poles/singularities.");
+  }
+}
+
+void requireFinite(const JetStatus& status) {
+  requireFinite(status.f);
+  requireFinite(status.df, "Derivative");
+}
+
 }
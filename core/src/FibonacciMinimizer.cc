@@ -0,0 +1,78 @@
+#include "FibonacciMinimizer.h"
+
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+#include "Expression.h"
+#include "LineSearch.h"
+#include "TraceSink.h"
+
+namespace matan {
+
+namespace {
+
+// The last pair would coincide at the midpoint; the second point is moved off it by this
+// fraction of the bracket so the final comparison still halves it.
+constexpr double kSplit = 1e-3;
+
+}
+
+FibonacciMinimizer::FibonacciMinimizer() : Minimizer("fibonacci") {}
+
+MinimizationResult FibonacciMinimizer::minimize(const MinimizationContext& ctx) const {
+  const Expression& f = ctx.f;
+  double a = ctx.a;
+  double b = ctx.b;
+  double eps = checkedEps(a, b, ctx.eps);
+  checkBudget(ctx.budget, 2, "fibonacci");
+
+  // fib[n] with fib[0] = fib[1] = 1; n evaluations leave a bracket of about (b - a) / fib[n].
+  std::vector<double> fib{1.0, 1.0, 2.0};
+  while ((b - a) / fib.back() > eps &&
+         (ctx.budget == 0 || static_cast<long>(fib.size() - 1) < ctx.budget)) {
+    fib.push_back(fib[fib.size() - 1] + fib[fib.size() - 2]);
+  }
+  const std::size_t n = fib.size() - 1;
+
+  return runTraced(ctx.trace, methodName(), [&](MinimizationResult& result, auto& sink) {
+    double y = a + fib[n - 2] / fib[n] * (b - a);
+    double z = n == 2 ? y + kSplit * (b - a) : a + fib[n - 1] / fib[n] * (b - a);
+    double fy = f.eval(y);
+    double fz = f.eval(z);
+    result.evaluations = 2;
+
+    int k = 0;
+    for (std::size_t m = n; m > 2; --m) {
+      sink(k, a, b, y, z, fy, fz);
+      if (fy <= fz) {
+        b = z;
+        z = y;
+        fz = fy;
+        y = m == 3 ? z - kSplit * (b - a) : a + fib[m - 3] / fib[m - 1] * (b - a);
+        fy = f.eval(y);
+      } else {
+        a = y;
+        y = z;
+        fy = fz;
+        z = m == 3 ? y + kSplit * (b - a) : a + fib[m - 2] / fib[m - 1] * (b - a);
+        fz = f.eval(z);
+      }
+      ++result.evaluations;
+      ++k;
+    }
+
+    // The last pair is only compared: every planned evaluation is spent by now.
+    sink(k, a, b, y, z, fy, fz);
+    if (fy <= fz) {
+      b = z;
+    } else {
+      a = y;
+    }
+    sink(k + 1, a, b, y, z, fy, fz);
+    result.x_min = fy <= fz ? y : z;
+    result.f_min = fy <= fz ? fy : fz;
+  });
+}
+
+}
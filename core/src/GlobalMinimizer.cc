@@ -0,0 +1,186 @@
+#include "GlobalMinimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "BrentMinimizer.h"
+#include "Expression.h"
+#include "Parallel.h"
+
+namespace matan {
+
+namespace {
+
+constexpr std::size_t kScanBlock = 1024;
+
+// Samples where f is not finite (poles, domain errors) never become candidates.
+std::vector<double> scan(const Expression& f, double a, double b, std::size_t n) {
+  double h = (b - a) / static_cast<double>(n - 1);
+  std::vector<double> ys(n);
+  std::vector<std::uint8_t> mask(n);
+  std::size_t blocks = (n + kScanBlock - 1) / kScanBlock;
+  MATAN_OMP_PARALLEL_FOR
+  for (std::ptrdiff_t blk = 0; blk < static_cast<std::ptrdiff_t>(blocks); ++blk) {
+    std::size_t begin = static_cast<std::size_t>(blk) * kScanBlock;
+    std::size_t len = std::min(n, begin + kScanBlock) - begin;
+    f.evalGrid(a + static_cast<double>(begin) * h, h, len,
+               std::span<double>(ys).subspan(begin, len),
+               std::span<std::uint8_t>(mask).subspan(begin, len));
+  }
+  for (std::size_t i = 0; i < n; ++i) {
+    if (mask[i]) {
+      ys[i] = std::numeric_limits<double>::infinity();
+    }
+  }
+  return ys;
+}
+
+// Indices of sampled local minima; on a plateau only its left end counts.
+std::vector<std::size_t> candidates(const std::vector<double>& ys) {
+  std::vector<std::size_t> out;
+  std::size_t n = ys.size();
+  for (std::size_t i = 0; i < n; ++i) {
+    if (!std::isfinite(ys[i])) {
+      continue;
+    }
+    bool left = i == 0 || ys[i] < ys[i - 1];
+    bool right = i + 1 == n || ys[i] <= ys[i + 1];
+    if (left && right) {
+      out.push_back(i);
+    }
+  }
+  return out;
+}
+
+struct Basin {
+  MinimizationResult local;
+  std::exception_ptr error;
+};
+
+}
+
+GlobalMinimizer::GlobalMinimizer(int samples) : Minimizer("global"), samples_(samples) {}
+
+MinimizationResult GlobalMinimizer::minimize(const MinimizationContext& ctx) const {
+  const Expression& f = ctx.f;
+  double a = ctx.a;
+  double b = ctx.b;
+  if (a >= b) {
+    throw std::runtime_error("Invalid interval: a must be less than b");
+  }
+  if (ctx.eps <= 0.0) {
+    throw std::runtime_error("Invalid eps: must be positive");
+  }
+  if (samples_ < 3) {
+    throw std::runtime_error("Invalid samples: need at least 3 points");
+  }
+  if (ctx.budget < 0 || (ctx.budget > 0 && ctx.budget <= samples_)) {
+    throw std::runtime_error("Invalid budget: global needs more evaluations than samples");
+  }
+  if (ctx.trace.mode == TraceMode::Stream && !ctx.trace.stream) {
+    throw std::runtime_error("Stream trace needs a callback");
+  }
+
+  std::size_t n = static_cast<std::size_t>(samples_);
+  double h = (b - a) / static_cast<double>(n - 1);
+  auto sample_x = [&](std::size_t i) { return i + 1 == n ? b : a + static_cast<double>(i) * h; };
+  std::vector<double> ys = scan(f, a, b, n);
+  std::vector<std::size_t> starts = candidates(ys);
+  if (starts.empty()) {
+    throw std::runtime_error("Function is not finite anywhere on the sampled interval");
+  }
+
+  // Under a budget only the lowest sampled minima are refined, and what is left after the scan
+  // is shared among them, the lowest first.
+  std::vector<long> basin_budget(starts.size(), 0);
+  if (ctx.budget > 0) {
+    long left = ctx.budget - static_cast<long>(n);
+    std::stable_sort(starts.begin(), starts.end(),
+                     [&](std::size_t l, std::size_t r) { return ys[l] < ys[r]; });
+    starts.resize(std::min(starts.size(), static_cast<std::size_t>(left)));
+    long count = static_cast<long>(starts.size());
+    basin_budget.assign(starts.size(), left / count);
+    for (long c = 0; c < left % count; ++c) {
+      ++basin_budget[static_cast<std::size_t>(c)];
+    }
+  }
+
+  // Basins run concurrently, so a streamed trace is collected and replayed for the winner only.
+  TraceOptions basin_trace = ctx.trace;
+  if (basin_trace.mode == TraceMode::Stream) {
+    basin_trace.mode = TraceMode::Full;
+  }
+
+  // Exceptions must not leave the parallel region; the first one is rethrown afterwards.
+  std::vector<Basin> basins(starts.size());
+  BrentMinimizer local;
+  MATAN_OMP_PARALLEL_FOR
+  for (std::ptrdiff_t c = 0; c < static_cast<std::ptrdiff_t>(starts.size()); ++c) {
+    std::size_t i = starts[c];
+    double lo = sample_x(i == 0 ? 0 : i - 1);
+    double hi = sample_x(std::min(n - 1, i + 1));
+    try {
+      basins[c].local = local.minimize(
+          MinimizationContext{f, lo, hi, ctx.eps, basin_budget[c], basin_trace});
+      // Brent never evaluates the bracket ends, so a minimum at a or b is taken from the scan.
+      if ((i == 0 || i + 1 == n) && ys[i] < basins[c].local.f_min) {
+        basins[c].local.x_min = sample_x(i);
+        basins[c].local.f_min = ys[i];
+      }
+    } catch (...) {
+      basins[c].error = std::current_exception();
+    }
+  }
+  for (const auto& basin : basins) {
+    if (basin.error) {
+      std::rethrow_exception(basin.error);
+    }
+  }
+
+  std::vector<std::size_t> order(basins.size());
+  for (std::size_t c = 0; c < order.size(); ++c) {
+    order[c] = c;
+  }
+  std::sort(order.begin(), order.end(), [&](std::size_t l, std::size_t r) {
+    const auto& lm = basins[l].local;
+    const auto& rm = basins[r].local;
+    return lm.f_min < rm.f_min || (lm.f_min == rm.f_min && lm.x_min < rm.x_min);
+  });
+
+  MinimizationResult result;
+  result.method = methodName();
+  result.evaluations = static_cast<long>(n);
+  for (const auto& basin : basins) {
+    result.evaluations += basin.local.evaluations;
+  }
+  for (std::size_t c : order) {
+    const auto& m = basins[c].local;
+    bool duplicate = std::any_of(result.minima.begin(), result.minima.end(), [&](const auto& seen) {
+      return std::fabs(seen.x - m.x_min) <= ctx.eps;
+    });
+    if (!duplicate) {
+      result.minima.push_back(LocalMinimum{m.x_min, m.f_min});
+    }
+  }
+  MinimizationResult& best = basins[order.front()].local;
+  result.x_min = best.x_min;
+  result.f_min = best.f_min;
+  result.iterations = std::move(best.iterations);
+  if (ctx.trace.mode == TraceMode::Stream) {
+    for (const auto& state : result.iterations) {
+      ctx.trace.stream(state);
+    }
+    result.iterations.clear();
+  }
+  return result;
+}
+
+}
@@ -1,69 +1,29 @@
 #include "GoldenSectionMinimizer.h"
 
-#include <cmath>
-#include <stdexcept>
+#include <vector>
 
 #include "Expression.h"
+#include "LineSearch.h"
+#include "TraceSink.h"
 
 namespace matan {
 
 GoldenSectionMinimizer::GoldenSectionMinimizer() : Minimizer("golden") {}
 
 MinimizationResult GoldenSectionMinimizer::minimize(const MinimizationContext& ctx) const {
-  const Expression& f = ctx.f;
-  double a = ctx.a;
-  double b = ctx.b;
-  double eps = ctx.eps;
-  if (a >= b) {
-    throw std::runtime_error("Invalid interval: a must be less than b");
-  }
-  constexpr double kMinEps = 1e-12;
-  if (eps <= 0.0) {
-    throw std::runtime_error("Invalid eps: must be positive");
-  }
-  if (eps < kMinEps) {
-    eps = kMinEps;
-  }
-
-  const double tau = (std::sqrt(5.0) - 1.0) * 0.5;
-  double y = a + (1.0 - tau) * (b - a);
-  double z = a + tau * (b - a);
-  double fy = f.eval(y);
-  double fz = f.eval(z);
-
-  MinimizationResult result;
-  int k = 0;
-
-  const int max_iters = 2'000'000;
-  while (true) {
-    logIteration(result, k, a, b, y, z, fy, fz);
-
-    if ((b - a) <= eps) {
-      break;
-    }
-
-    if (fy <= fz) {
-      b = z;
-      z = y;
-      fz = fy;
-      y = a + (1.0 - tau) * (b - a);
-      fy = f.eval(y);
-    } else {
-      a = y;
-      y = z;
-      fy = fz;
-      z = a + tau * (b - a);
-      fz = f.eval(z);
-    }
-    ++k;
-    if (k > max_iters) {
-      throw std::runtime_error("GoldenSectionMinimizer: iteration limit exceeded; eps may be too small");
-    }
-  }
+  GoldenSearch search(ctx.a, ctx.b, ctx.eps, ctx.budget);
+  return runTraced(ctx.trace, methodName(), [&](MinimizationResult& result, auto& sink) {
+    runSearch(ctx.f, search, sink);
+    result.x_min = search.x_min();
+    result.f_min = search.f_min();
+    result.evaluations = search.evaluations();
+  });
+}
 
-  result.x_min = 0.5 * (a + b);
-  result.f_min = f.eval(result.x_min);
-  return result;
+std::vector<MinimizationResult> GoldenSectionMinimizer::minimizeBatch(
+    const Expression& f, std::span<const MinimizationProblem> problems,
+    const TraceOptions& trace) const {
+  return minimizeLockstep<GoldenSearch>(f, problems, methodName(), trace);
 }
 
 }
@@ -0,0 +1,45 @@
+#include "HighOrderCentralDifference.h"
+
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "DiffCommon.h"
+#include "Stencil.h"
+
+namespace matan {
+
+namespace {
+
+int checkedOrder(int order) {
+  if (order != 4 && order != 6 && order != 8) {
+    throw std::runtime_error("Unsupported central difference order: " + std::to_string(order));
+  }
+  return order;
+}
+
+}
+
+HighOrderCentralDifference::HighOrderCentralDifference(int order)
+    : Differentiator("central" + std::to_string(checkedOrder(order))), order_(order) {}
+
+DerivativeResult HighOrderCentralDifference::differentiate(
+    const DifferentiationContext& ctx) const {
+  requireUniformGrid(ctx, "central" + std::to_string(order_));
+  auto grid = buildGrid(ctx.f, ctx.df, ctx.a, ctx.b, ctx.h);
+  std::vector<double> d_est;
+  switch (order_) {
+    case 4:
+      d_est = applyScheme<CentralOrderScheme<4>>(grid.y, grid.h);
+      break;
+    case 6:
+      d_est = applyScheme<CentralOrderScheme<6>>(grid.y, grid.h);
+      break;
+    default:
+      d_est = applyScheme<CentralOrderScheme<8>>(grid.y, grid.h);
+      break;
+  }
+  return makeResult(shareGrid(std::move(grid)), std::move(d_est));
+}
+
+}
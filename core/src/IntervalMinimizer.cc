@@ -0,0 +1,136 @@
+#include "IntervalMinimizer.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <queue>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "Expression.h"
+#include "LineSearch.h"
+#include "TraceSink.h"
+
+namespace matan {
+
+namespace {
+
+constexpr std::size_t kMaxBoxes = 1'000'000;
+// A box whose lower bound is this close to the best value (relative, at least 1) cannot hold a
+// noticeably better point and is not split further, unless it holds the best point itself.
+constexpr double kGapTol = 1e-12;
+// Splitting a box costs two interval evaluations and the two child midpoints.
+constexpr long kSplitCost = 4;
+
+struct Box {
+  double lo = 0.0;
+  double hi = 0.0;
+  double lb = 0.0;
+};
+
+// Orders the heap by lower bound, ties to the leftmost box.
+struct WorseBox {
+  bool operator()(const Box& l, const Box& r) const {
+    return l.lb > r.lb || (l.lb == r.lb && l.lo > r.lo);
+  }
+};
+
+}
+
+IntervalMinimizer::IntervalMinimizer() : Minimizer("interval") {}
+
+MinimizationResult IntervalMinimizer::minimize(const MinimizationContext& ctx) const {
+  const Expression& f = ctx.f;
+  double a = ctx.a;
+  double b = ctx.b;
+  double eps = checkedEps(a, b, ctx.eps);
+  checkBudget(ctx.budget, kSplitCost, "interval");
+  if (!f.supportsIntervals()) {
+    throw std::runtime_error("IntervalMinimizer: interval evaluation is not supported for " +
+                             f.source());
+  }
+
+  return runTraced(ctx.trace, methodName(), [&](MinimizationResult& result, auto& sink) {
+    constexpr double kInf = std::numeric_limits<double>::infinity();
+    double best_x = 0.5 * (a + b);
+    double best_f = kInf;
+    // Points where f is not finite are skipped; only finite values become the best one.
+    auto sample = [&](std::span<const double> xs) {
+      std::array<double, 3> ys{};
+      std::array<std::uint8_t, 3> mask{};
+      f.evalBatch(xs, std::span<double>(ys).first(xs.size()),
+                  std::span<std::uint8_t>(mask).first(xs.size()));
+      for (std::size_t i = 0; i < xs.size(); ++i) {
+        if (!mask[i] && ys[i] < best_f) {
+          best_x = xs[i];
+          best_f = ys[i];
+        }
+      }
+    };
+
+    std::priority_queue<Box, std::vector<Box>, WorseBox> boxes;
+    Interval root = f.evalInterval({a, b});
+    std::array<double, 3> ends{a, 0.5 * (a + b), b};
+    sample(ends);
+    result.evaluations = kSplitCost;
+    if (!root.empty()) {
+      boxes.push({a, b, root.lo});
+    }
+
+    double done_lb = kInf;
+    int k = 0;
+    while (!boxes.empty()) {
+      Box box = boxes.top();
+      // Every box left lies above the best value, so none can hold the minimum.
+      if (box.lb > best_f) {
+        break;
+      }
+      double mid = 0.5 * (box.lo + box.hi);
+      // The value gap only retires boxes away from the best point; the box holding it is split
+      // down to eps, so x_min is located as precisely as by the other methods.
+      bool holds_best = box.lo <= best_x && best_x <= box.hi;
+      bool finished = box.hi - box.lo <= eps ||
+                      (!holds_best &&
+                       best_f - box.lb <= kGapTol * std::max(1.0, std::fabs(best_f)));
+      if (!finished && ctx.budget > 0 && result.evaluations + kSplitCost > ctx.budget) {
+        break;
+      }
+      sink(k, box.lo, box.hi, best_x, mid, best_f, box.lb);
+      ++k;
+      boxes.pop();
+      if (finished) {
+        done_lb = std::min(done_lb, box.lb);
+        continue;
+      }
+
+      std::array<Interval, 2> halves{Interval{box.lo, mid}, Interval{mid, box.hi}};
+      std::array<Interval, 2> bounds{};
+      f.evalIntervalBatch(halves, bounds);
+      std::array<double, 2> mids{0.5 * (box.lo + mid), 0.5 * (mid + box.hi)};
+      sample(mids);
+      result.evaluations += kSplitCost;
+      for (std::size_t i = 0; i < 2; ++i) {
+        if (!bounds[i].empty() && bounds[i].lo <= best_f) {
+          boxes.push({halves[i].lo, halves[i].hi, bounds[i].lo});
+        }
+      }
+      if (boxes.size() > kMaxBoxes) {
+        throw std::runtime_error("IntervalMinimizer: box limit exceeded; eps may be too small");
+      }
+    }
+
+    if (!std::isfinite(best_f)) {
+      throw std::runtime_error("Function is not finite anywhere on the interval");
+    }
+    double open_lb = boxes.empty() ? kInf : boxes.top().lb;
+    result.x_min = best_x;
+    result.f_min = best_f;
+    result.f_lower = std::min({done_lb, open_lb, best_f});
+  });
+}
+
+}
@@ -0,0 +1,127 @@
+#include "KSectionMinimizer.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "Expression.h"
+#include "LineSearch.h"
+#include "Parallel.h"
+#include "TraceSink.h"
+
+namespace matan {
+
+KSectionMinimizer::KSectionMinimizer(int sections) : Minimizer("ksection"), sections_(sections) {}
+
+MinimizationResult KSectionMinimizer::minimize(const MinimizationContext& ctx) const {
+  const Expression& f = ctx.f;
+  double a = ctx.a;
+  double b = ctx.b;
+  double eps = ctx.eps;
+  if (a >= b) {
+    throw std::runtime_error("Invalid interval: a must be less than b");
+  }
+  constexpr double kMinEps = 1e-12;
+  if (eps <= 0.0) {
+    throw std::runtime_error("Invalid eps: must be positive");
+  }
+  if (eps < kMinEps) {
+    eps = kMinEps;
+  }
+  int sections = sections_ > 0 ? sections_ : std::max(2, threadCount());
+  if (sections < 2) {
+    throw std::runtime_error("Invalid sections: need at least 2 points per round");
+  }
+  checkBudget(ctx.budget, 3, "ksection");
+
+  std::size_t m = static_cast<std::size_t>(sections);
+  std::vector<double> xs(m);
+  std::vector<double> ys(m);
+  std::vector<std::uint8_t> mask(m);
+
+  return runTraced(ctx.trace, methodName(), [&](MinimizationResult& result, auto& sink) {
+    int k = 0;
+    double y = 0.5 * (a + b);
+    double z = y;
+    double fy = 0.0;
+    double fz = 0.0;
+    bool sampled = false;
+
+    const int max_iters = 2'000'000;
+    while ((b - a) > eps) {
+      // Under a budget the last rounds shrink so one evaluation is left for the midpoint.
+      std::size_t r = m;
+      if (ctx.budget > 0) {
+        long left = ctx.budget - result.evaluations - 1;
+        if (left < 2) {
+          break;
+        }
+        r = std::min(m, static_cast<std::size_t>(left));
+      }
+      double h = (b - a) / static_cast<double>(r + 1);
+      for (std::size_t i = 0; i < r; ++i) {
+        xs[i] = a + static_cast<double>(i + 1) * h;
+      }
+      // One point per iteration so a slow objective spreads over the whole team.
+      MATAN_OMP_PARALLEL_FOR
+      for (std::ptrdiff_t i = 0; i < static_cast<std::ptrdiff_t>(r); ++i) {
+        std::size_t j = static_cast<std::size_t>(i);
+        f.evalBatch(std::span<const double>(xs).subspan(j, 1), std::span<double>(ys).subspan(j, 1),
+                    std::span<std::uint8_t>(mask).subspan(j, 1));
+      }
+      result.evaluations += static_cast<long>(r);
+      EvalStatus status;
+      for (std::size_t i = 0; i < r; ++i) {
+        if (mask[i] && status.non_finite++ == 0) {
+          status.first_index = i;
+          status.first_x = xs[i];
+        }
+      }
+      requireFinite(status);
+
+      // Ties go to the leftmost point so the result does not depend on the thread count.
+      auto ys_end = ys.begin() + static_cast<std::ptrdiff_t>(r);
+      std::size_t best = static_cast<std::size_t>(std::min_element(ys.begin(), ys_end) - ys.begin());
+      std::size_t second = best == 0 ? 1 : best - 1;
+      if (best + 1 < r && ys[best + 1] < ys[second]) {
+        second = best + 1;
+      }
+      y = xs[best];
+      z = xs[second];
+      fy = ys[best];
+      fz = ys[second];
+      sampled = true;
+      sink(k, a, b, y, z, fy, fz);
+
+      double lo = best == 0 ? a : xs[best - 1];
+      double hi = best + 1 == r ? b : xs[best + 1];
+      a = lo;
+      b = hi;
+      ++k;
+      if (k > max_iters) {
+        throw std::runtime_error("KSectionMinimizer: iteration limit exceeded; eps may be too small");
+      }
+    }
+    // The final bracket is logged with the last round's points instead of sampling it again, and
+    // the midpoint is only evaluated when it is not already the best sampled point.
+    result.x_min = 0.5 * (a + b);
+    if (!sampled) {
+      fy = f.eval(y);
+      fz = fy;
+      ++result.evaluations;
+    }
+    sink(k, a, b, y, z, fy, fz);
+
+    if (result.x_min == y) {
+      result.f_min = fy;
+    } else {
+      result.f_min = f.eval(result.x_min);
+      ++result.evaluations;
+    }
+  });
+}
+
+}
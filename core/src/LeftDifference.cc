@@ -1,34 +1,25 @@
 #include "LeftDifference.h"
 
+#include <utility>
+
 #include "DiffCommon.h"
-#include "Expression.h"
+#include "NonUniformGrid.h"
+#include "Stencil.h"
 
 namespace matan {
 
 LeftDifference::LeftDifference() : Differentiator("left") {}
 
 DerivativeResult LeftDifference::differentiate(const DifferentiationContext& ctx) const {
-  auto grid = buildGrid(ctx.f, ctx.a, ctx.b, ctx.h);
-  DerivativeResult result;
-  result.h = grid.h;
-
-  const auto& x = grid.x;
-  const auto& y = grid.y;
-  int n = static_cast<int>(x.size());
-
-  for (int i = 0; i < n; ++i) {
-    double d_est = 0.0;
-    if (i == 0) {
-      d_est = leftBoundaryDerivative(y, grid.h);
-    } else {
-      d_est = (y[i] - y[i - 1]) / grid.h;
-    }
-    double d_true = ctx.f.derivative(x[i]);
-    logSample(result, i, x[i], y[i], d_true, d_est);
+  if (ctx.grid == GridKind::Adaptive) {
+    auto grid =
+        buildAdaptiveGrid(ctx.f, ctx.df, ctx.a, ctx.b, ctx.h, ctx.tol, 1, ctx.max_points);
+    auto d_est = applyNonUniform(NonUniformScheme::Left, grid);
+    return makeResult(shareGrid(std::move(grid)), std::move(d_est));
   }
-
-  finalize(result);
-  return result;
+  auto grid = buildGrid(ctx.f, ctx.df, ctx.a, ctx.b, ctx.h);
+  auto d_est = applyScheme<LeftScheme>(grid.y, grid.h);
+  return makeResult(shareGrid(std::move(grid)), std::move(d_est));
 }
 
 }
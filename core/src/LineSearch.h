@@ -0,0 +1,389 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Expression.h"
+#include "Minimizer.h"
+#include "TraceSink.h"
+
+namespace matan {
+
+// Golden-section and Brent iterations split at their function evaluations, so one driver loop
+// serves a single problem (eval) and many problems in lockstep (evalBatch) with identical steps:
+//
+//   while (search.advance(log)) search.accept(f(search.point()));
+//
+// advance() reports each finished iteration through log(k, a, b, y, z, fy, fz) and returns false
+// once x_min()/f_min() are final. A positive budget caps the number of evaluations; the search
+// then stops early with the best estimate it can still afford.
+
+inline double checkedEps(double a, double b, double eps) {
+  if (a >= b) {
+    throw std::runtime_error("Invalid interval: a must be less than b");
+  }
+  constexpr double kMinEps = 1e-12;
+  if (eps <= 0.0) {
+    throw std::runtime_error("Invalid eps: must be positive");
+  }
+  return eps < kMinEps ? kMinEps : eps;
+}
+
+inline void checkBudget(long budget, long needed, const char* method) {
+  if (budget < 0) {
+    throw std::runtime_error("Invalid budget: must be non-negative");
+  }
+  if (budget > 0 && budget < needed) {
+    throw std::runtime_error(std::string("Invalid budget: ") + method + " needs at least " +
+                             std::to_string(needed) + " evaluations");
+  }
+}
+
+inline constexpr int kLineSearchMaxIters = 2'000'000;
+
+class GoldenSearch {
+ public:
+  GoldenSearch(double a, double b, double eps, long budget = 0)
+      : a_(a), b_(b), eps_(checkedEps(a, b, eps)), budget_(budget) {
+    checkBudget(budget_, 3, "golden");
+    y_ = a_ + (1.0 - kTau) * (b_ - a_);
+    z_ = a_ + kTau * (b_ - a_);
+  }
+
+  template <class Log>
+  bool advance(Log&& log) {
+    switch (stage_) {
+      case Stage::Start:
+        stage_ = Stage::WaitFirstY;
+        point_ = y_;
+        return true;
+      case Stage::StartZ:
+        stage_ = Stage::WaitZ;
+        point_ = z_;
+        return true;
+      case Stage::Iterate:
+        break;
+      default:
+        return false;
+    }
+    log(k_, a_, b_, y_, z_, fy_, fz_);
+    // One more step must leave an evaluation for the midpoint.
+    if ((b_ - a_) <= eps_ || (budget_ > 0 && evals_ + 2 > budget_)) {
+      stage_ = Stage::WaitFinal;
+      point_ = 0.5 * (a_ + b_);
+      return true;
+    }
+    if (fy_ <= fz_) {
+      b_ = z_;
+      z_ = y_;
+      fz_ = fy_;
+      y_ = a_ + (1.0 - kTau) * (b_ - a_);
+      point_ = y_;
+      stage_ = Stage::WaitY;
+    } else {
+      a_ = y_;
+      y_ = z_;
+      fy_ = fz_;
+      z_ = a_ + kTau * (b_ - a_);
+      point_ = z_;
+      stage_ = Stage::WaitZ;
+    }
+    ++k_;
+    if (k_ > kLineSearchMaxIters) {
+      throw std::runtime_error("GoldenSectionMinimizer: iteration limit exceeded; eps may be too small");
+    }
+    return true;
+  }
+
+  double point() const {
+    return point_;
+  }
+
+  void accept(double fx) {
+    ++evals_;
+    switch (stage_) {
+      case Stage::WaitFirstY:
+        fy_ = fx;
+        stage_ = Stage::StartZ;
+        break;
+      case Stage::WaitY:
+        fy_ = fx;
+        stage_ = Stage::Iterate;
+        break;
+      case Stage::WaitZ:
+        fz_ = fx;
+        stage_ = Stage::Iterate;
+        break;
+      case Stage::WaitFinal:
+        f_min_ = fx;
+        stage_ = Stage::Done;
+        break;
+      default:
+        break;
+    }
+  }
+
+  double x_min() const {
+    return point_;
+  }
+  double f_min() const {
+    return f_min_;
+  }
+  long evaluations() const {
+    return evals_;
+  }
+
+ private:
+  enum class Stage { Start, WaitFirstY, StartZ, WaitY, WaitZ, Iterate, WaitFinal, Done };
+  static inline const double kTau = (std::sqrt(5.0) - 1.0) * 0.5;
+
+  Stage stage_ = Stage::Start;
+  int k_ = 0;
+  double a_;
+  double b_;
+  double eps_;
+  long budget_;
+  long evals_ = 0;
+  double y_ = 0.0;
+  double z_ = 0.0;
+  double fy_ = 0.0;
+  double fz_ = 0.0;
+  double point_ = 0.0;
+  double f_min_ = 0.0;
+};
+
+class BrentSearch {
+ public:
+  BrentSearch(double a, double b, double eps, long budget = 0)
+      : a_(a), b_(b), eps_(checkedEps(a, b, eps)), budget_(budget) {
+    checkBudget(budget_, 1, "brent");
+    x_ = a_ + kGolden * (b_ - a_);
+    w_ = x_;
+    v_ = x_;
+  }
+
+  template <class Log>
+  bool advance(Log&& log) {
+    switch (stage_) {
+      case Stage::Start:
+        stage_ = Stage::WaitX;
+        point_ = x_;
+        return true;
+      case Stage::Iterate:
+        break;
+      default:
+        return false;
+    }
+    log(k_, a_, b_, x_, w_, fx_, fw_);
+
+    // Stops once [a, b] is within 2 * tol1 of x on both sides, i.e. b - a <= eps.
+    double xm = 0.5 * (a_ + b_);
+    double tol1 = kRelTol * std::fabs(x_) + 0.25 * eps_;
+    double tol2 = 2.0 * tol1;
+    if (std::fabs(x_ - xm) <= tol2 - 0.5 * (b_ - a_) || (budget_ > 0 && evals_ >= budget_)) {
+      stage_ = Stage::Done;
+      return false;
+    }
+
+    bool parabolic = false;
+    if (std::fabs(e_) > tol1) {
+      double r = (x_ - w_) * (fx_ - fv_);
+      double q = (x_ - v_) * (fx_ - fw_);
+      double p = (x_ - v_) * q - (x_ - w_) * r;
+      q = 2.0 * (q - r);
+      if (q > 0.0) {
+        p = -p;
+      } else {
+        q = -q;
+      }
+      double e_prev = e_;
+      e_ = d_;
+      if (std::fabs(p) < std::fabs(0.5 * q * e_prev) && p > q * (a_ - x_) && p < q * (b_ - x_)) {
+        d_ = p / q;
+        double u = x_ + d_;
+        if (u - a_ < tol2 || b_ - u < tol2) {
+          d_ = std::copysign(tol1, xm - x_);
+        }
+        parabolic = true;
+      }
+    }
+    if (!parabolic) {
+      e_ = x_ >= xm ? a_ - x_ : b_ - x_;
+      d_ = kGolden * e_;
+    }
+
+    point_ = std::fabs(d_) >= tol1 ? x_ + d_ : x_ + std::copysign(tol1, d_);
+    stage_ = Stage::WaitU;
+    return true;
+  }
+
+  double point() const {
+    return point_;
+  }
+
+  void accept(double fu) {
+    ++evals_;
+    if (stage_ == Stage::WaitX) {
+      fx_ = fu;
+      fw_ = fu;
+      fv_ = fu;
+      stage_ = Stage::Iterate;
+      return;
+    }
+    if (stage_ != Stage::WaitU) {
+      return;
+    }
+    double u = point_;
+    if (fu <= fx_) {
+      if (u >= x_) {
+        a_ = x_;
+      } else {
+        b_ = x_;
+      }
+      v_ = w_;
+      fv_ = fw_;
+      w_ = x_;
+      fw_ = fx_;
+      x_ = u;
+      fx_ = fu;
+    } else {
+      if (u < x_) {
+        a_ = u;
+      } else {
+        b_ = u;
+      }
+      if (fu <= fw_ || w_ == x_) {
+        v_ = w_;
+        fv_ = fw_;
+        w_ = u;
+        fw_ = fu;
+      } else if (fu <= fv_ || v_ == x_ || v_ == w_) {
+        v_ = u;
+        fv_ = fu;
+      }
+    }
+    stage_ = Stage::Iterate;
+    ++k_;
+    if (k_ > kLineSearchMaxIters) {
+      throw std::runtime_error("BrentMinimizer: iteration limit exceeded; eps may be too small");
+    }
+  }
+
+  double x_min() const {
+    return x_;
+  }
+  double f_min() const {
+    return fx_;
+  }
+  long evaluations() const {
+    return evals_;
+  }
+
+ private:
+  enum class Stage { Start, WaitX, WaitU, Iterate, Done };
+  // x is the best point so far, w the second best and v the previous w; d is the last step and e
+  // the one before it, which a parabolic step must undercut to be accepted.
+  static inline const double kGolden = 0.5 * (3.0 - std::sqrt(5.0));
+  static constexpr double kRelTol = 2.0 * std::numeric_limits<double>::epsilon();
+
+  Stage stage_ = Stage::Start;
+  int k_ = 0;
+  double a_;
+  double b_;
+  double eps_;
+  long budget_;
+  long evals_ = 0;
+  double x_ = 0.0;
+  double w_ = 0.0;
+  double v_ = 0.0;
+  double fx_ = 0.0;
+  double fw_ = 0.0;
+  double fv_ = 0.0;
+  double d_ = 0.0;
+  double e_ = 0.0;
+  double point_ = 0.0;
+};
+
+// Drives one search with scalar eval(); log is called as in advance().
+template <class Search, class Log>
+void runSearch(const Expression& f, Search& search, Log&& log) {
+  while (search.advance(log)) {
+    search.accept(f.eval(search.point()));
+  }
+}
+
+// Advances every search in lockstep: each round gathers the pending point of every unfinished
+// search into one evalBatch call, and finished searches drop out of the active set. log is called
+// as log(problem_index, k, a, b, y, z, fy, fz).
+template <class Search, class Log>
+void runLockstep(const Expression& f, std::vector<Search>& searches, Log&& log) {
+  std::vector<std::size_t> active(searches.size());
+  for (std::size_t i = 0; i < active.size(); ++i) {
+    active[i] = i;
+  }
+  std::vector<double> xs;
+  std::vector<double> ys;
+  xs.reserve(active.size());
+  ys.reserve(active.size());
+  while (!active.empty()) {
+    std::size_t kept = 0;
+    xs.clear();
+    for (std::size_t i : active) {
+      auto log_i = [&](int k, double a, double b, double y, double z, double fy, double fz) {
+        log(i, k, a, b, y, z, fy, fz);
+      };
+      if (searches[i].advance(log_i)) {
+        active[kept++] = i;
+        xs.push_back(searches[i].point());
+      }
+    }
+    active.resize(kept);
+    ys.resize(kept);
+    requireFinite(f.evalBatch(xs, ys));
+    for (std::size_t j = 0; j < kept; ++j) {
+      searches[active[j]].accept(ys[j]);
+    }
+  }
+}
+
+// Minimizer::minimizeBatch for a step-object search: one Search per problem, all advanced by
+// runLockstep, each with its own sink of the type selected by `trace`.
+template <class Search>
+std::vector<MinimizationResult> minimizeLockstep(const Expression& f,
+                                                 std::span<const MinimizationProblem> problems,
+                                                 const std::string& method,
+                                                 const TraceOptions& trace) {
+  std::vector<Search> searches;
+  searches.reserve(problems.size());
+  for (const auto& p : problems) {
+    searches.emplace_back(p.a, p.b, p.eps, p.budget);
+  }
+  std::vector<MinimizationResult> results(problems.size());
+  withTraceSink(trace, [&](auto make) {
+    std::vector<decltype(make())> sinks;
+    sinks.reserve(problems.size());
+    for (std::size_t i = 0; i < problems.size(); ++i) {
+      sinks.push_back(make());
+    }
+    runLockstep(f, searches,
+                [&](std::size_t i, int k, double a, double b, double y, double z, double fy,
+                    double fz) { sinks[i](k, a, b, y, z, fy, fz); });
+    for (std::size_t i = 0; i < results.size(); ++i) {
+      sinks[i].finish(results[i].iterations);
+    }
+  });
+  for (std::size_t i = 0; i < results.size(); ++i) {
+    results[i].method = method;
+    results[i].x_min = searches[i].x_min();
+    results[i].f_min = searches[i].f_min();
+    results[i].evaluations = searches[i].evaluations();
+  }
+  return results;
+}
+
+}
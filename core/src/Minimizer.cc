@@ -6,22 +6,19 @@ namespace matan {
 
 Minimizer::Minimizer(std::string method_name) : method_name_(std::move(method_name)) {}
 
-void Minimizer::logIteration(MinimizationResult& result, int k, double a, double b, double y,
-                             double z, double fy, double fz) const {
-  if (result.method.empty()) {
-    result.method = method_name_;
+std::vector<MinimizationResult> Minimizer::minimizeBatch(
+    const Expression& f, std::span<const MinimizationProblem> problems,
+    const TraceOptions& trace) const {
+  std::vector<MinimizationResult> results;
+  results.reserve(problems.size());
+  for (const auto& p : problems) {
+    results.push_back(minimize(MinimizationContext{f, p.a, p.b, p.eps, p.budget, trace}));
   }
-  IterationState state;
-  state.k = k;
-  state.a = a;
-  state.b = b;
-  state.y = y;
-  state.z = z;
-  state.fy = fy;
-  state.fz = fz;
-  state.x_star = 0.5 * (a + b);
-  state.length = b - a;
-  result.iterations.push_back(state);
+  return results;
+}
+
+const std::string& Minimizer::methodName() const {
+  return method_name_;
 }
 
 }
@@ -0,0 +1,128 @@
+#include "NewtonMinimizer.h"
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "Expression.h"
+#include "LineSearch.h"
+#include "TraceSink.h"
+
+namespace matan {
+
+namespace {
+
+constexpr double kRelTol = 2.0 * std::numeric_limits<double>::epsilon();
+
+}
+
+NewtonMinimizer::NewtonMinimizer() : Minimizer("newton") {}
+
+MinimizationResult NewtonMinimizer::minimize(const MinimizationContext& ctx) const {
+  const Expression& f = ctx.f;
+  double a = ctx.a;
+  double b = ctx.b;
+  double eps = ctx.eps;
+  if (a >= b) {
+    throw std::runtime_error("Invalid interval: a must be less than b");
+  }
+  constexpr double kMinEps = 1e-12;
+  if (eps <= 0.0) {
+    throw std::runtime_error("Invalid eps: must be positive");
+  }
+  if (eps < kMinEps) {
+    eps = kMinEps;
+  }
+  checkBudget(ctx.budget, 3, "newton");
+
+  return runTraced(ctx.trace, methodName(), [&](MinimizationResult& result, auto& sink) {
+    // A unimodal f with f' of one sign on [a, b] is smallest at an end.
+    Jet ja = f.evalJet(a);
+    Jet jb = f.evalJet(b);
+    result.evaluations = 2;
+    if (ja.df >= 0.0 || jb.df <= 0.0) {
+      bool left = ja.df >= 0.0 && (jb.df > 0.0 || ja.f <= jb.f);
+      sink(0, a, b, a, b, ja.f, jb.f);
+      result.x_min = left ? a : b;
+      result.f_min = left ? ja.f : jb.f;
+      return;
+    }
+
+    const double golden = 0.5 * (3.0 - std::sqrt(5.0));
+    double x = 0.5 * (a + b);
+    Jet jx = f.evalJet(x);
+    ++result.evaluations;
+    double x_prev = a;
+    double f_prev = ja.f;
+    // Bracket widths one and two iterations back.
+    double width_prev = b - a;
+    double width_prev2 = b - a;
+
+    int k = 0;
+    const int max_iters = 2'000'000;
+    while (true) {
+      // f'(a) < 0 < f'(b) always holds. A stationary point with f'' >= 0 is the minimum of a
+      // unimodal f; one with f'' < 0 is a maximum, left to the right like any descent.
+      bool minimum = jx.df == 0.0 && jx.d2f >= 0.0;
+      if (minimum) {
+        a = x;
+        b = x;
+        ja = jx;
+        jb = jx;
+      } else if (jx.df <= 0.0) {
+        a = x;
+        ja = jx;
+      } else {
+        b = x;
+        jb = jx;
+      }
+      sink(k, a, b, x_prev, x, f_prev, jx.f);
+
+      if ((b - a) <= eps || (ctx.budget > 0 && result.evaluations >= ctx.budget)) {
+        break;
+      }
+      // Newton iterates usually close in from one side, leaving the far end of [a, b] in place.
+      // As in rtsafe, a bracket that has not halved in two iterations forces a golden step.
+      bool stalled = (b - a) > 0.5 * width_prev2;
+      width_prev2 = width_prev;
+      width_prev = b - a;
+
+      // Steps start from the lower end: Newton where f is convex there, otherwise with the secant
+      // slope of f' across [a, b]. A step below tol is stretched to tol, so once the iterates
+      // converge it lands just past the minimum and the far end moves up to it.
+      bool from_a = ja.f <= jb.f;
+      double xn = from_a ? a : b;
+      double far = from_a ? b : a;
+      const Jet& jn = from_a ? ja : jb;
+      double curvature = jn.d2f > 0.0 ? jn.d2f : (jb.df - ja.df) / (b - a);
+      double tol = 0.25 * eps + kRelTol * std::fabs(xn);
+      double u = xn + golden * (far - xn);
+      if (!stalled && curvature > 0.0 && std::isfinite(curvature)) {
+        double d = -jn.df / curvature;
+        if (std::fabs(d) < tol) {
+          d = std::copysign(tol, d);
+        }
+        if (xn + d > a && xn + d < b) {
+          u = xn + d;
+        }
+      }
+
+      x_prev = x;
+      f_prev = jx.f;
+      x = u;
+      jx = f.evalJet(x);
+      ++result.evaluations;
+      ++k;
+      if (k > max_iters) {
+        throw std::runtime_error("NewtonMinimizer: iteration limit exceeded; eps may be too small");
+      }
+    }
+
+    // The last point may be a golden probe; the better end of the bracket is the estimate.
+    bool left = ja.f <= jb.f;
+    result.x_min = left ? a : b;
+    result.f_min = left ? ja.f : jb.f;
+  });
+}
+
+}
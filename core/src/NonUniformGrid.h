@@ -0,0 +1,170 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+#include "DiffCommon.h"
+#include "Expression.h"
+#include "Parallel.h"
+
+namespace matan {
+
+enum class NonUniformScheme { Right, Left, Central };
+
+// Derivative at node lo + p of the Lagrange interpolant through nodes lo .. lo + count - 1.
+inline double lagrangeDerivative(const double* x, const double* y, std::size_t lo,
+                                 std::size_t count, std::size_t p) {
+  double xp = x[lo + p];
+  double d = 0.0;
+  for (std::size_t k = 0; k < count; ++k) {
+    double w = 0.0;
+    if (k == p) {
+      for (std::size_t m = 0; m < count; ++m) {
+        if (m != p) {
+          w += 1.0 / (xp - x[lo + m]);
+        }
+      }
+    } else {
+      w = 1.0 / (x[lo + k] - xp);
+      for (std::size_t m = 0; m < count; ++m) {
+        if (m != k && m != p) {
+          w *= (xp - x[lo + m]) / (x[lo + k] - x[lo + m]);
+        }
+      }
+    }
+    d += w * y[lo + k];
+  }
+  return d;
+}
+
+// Right, left and central differences with the weights of the actual spacing; the ends use the
+// three-point one-sided formulas, as on uniform grids.
+inline double nonUniformEstimate(NonUniformScheme scheme, const double* x, const double* y,
+                                 std::size_t n, std::size_t i) {
+  switch (scheme) {
+    case NonUniformScheme::Right:
+      return i + 1 < n ? lagrangeDerivative(x, y, i, 2, 0) : lagrangeDerivative(x, y, n - 3, 3, 2);
+    case NonUniformScheme::Left:
+      return i > 0 ? lagrangeDerivative(x, y, i - 1, 2, 1) : lagrangeDerivative(x, y, 0, 3, 0);
+    default:
+      if (i == 0) {
+        return lagrangeDerivative(x, y, 0, 3, 0);
+      }
+      if (i + 1 == n) {
+        return lagrangeDerivative(x, y, n - 3, 3, 2);
+      }
+      return lagrangeDerivative(x, y, i - 1, 3, 1);
+  }
+}
+
+inline std::vector<double> applyNonUniform(NonUniformScheme scheme, const GridData& grid) {
+  std::size_t n = grid.x.size();
+  if (n < 3) {
+    throw std::runtime_error("Invalid grid: need at least 3 points");
+  }
+  std::vector<double> d(n);
+  MATAN_OMP_PARALLEL_FOR
+  for (std::ptrdiff_t i = 0; i < static_cast<std::ptrdiff_t>(n); ++i) {
+    d[i] = nonUniformEstimate(scheme, grid.x.data(), grid.y.data(), n,
+                              static_cast<std::size_t>(i));
+  }
+  return d;
+}
+
+// Refinement driver: starts from the uniform grid with step h0 and bisects every interval whose
+// estimated truncation error exceeds tol, until none does or max_points is reached. The estimate
+// uses the exact f'' at the interval ends: h/2 * |f''| for first-order schemes and
+// h^2/6 * |f'''| ~ h/6 * |f''(x1) - f''(x0)| for second-order ones. Only new nodes are evaluated.
+inline GridData buildAdaptiveGrid(const Expression& f, const Expression* df, double a, double b,
+                                  double h0, double tol, int order, std::size_t max_points) {
+  constexpr int kMaxLevels = 40;
+  std::size_t n = gridPointCount(a, b, h0);
+  if (max_points < n) {
+    throw std::runtime_error("Invalid max_points: smaller than the initial grid");
+  }
+
+  GridData grid;
+  grid.a = a;
+  grid.h = h0;
+  grid.uniform = false;
+  grid.x.resize(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    grid.x[i] = a + static_cast<double>(i) * h0;
+  }
+  grid.y.resize(n);
+  grid.d_true.resize(n);
+  std::vector<double> d2(n);
+  evalReference(f, df, grid.x, grid.y, grid.d_true, d2);
+
+  std::vector<double> score;
+  std::vector<std::size_t> marked;
+  for (int level = 0; level < kMaxLevels; ++level) {
+    n = grid.x.size();
+    score.assign(n - 1, 0.0);
+    marked.clear();
+    for (std::size_t i = 0; i + 1 < n; ++i) {
+      double h = grid.x[i + 1] - grid.x[i];
+      double e = order == 1 ? 0.5 * h * std::max(std::fabs(d2[i]), std::fabs(d2[i + 1]))
+                            : h * std::fabs(d2[i + 1] - d2[i]) / 6.0;
+      // Stop before the midpoint stops being representable.
+      if (e > tol && grid.x[i] + 0.5 * h > grid.x[i] && grid.x[i] + 0.5 * h < grid.x[i + 1]) {
+        score[i] = e;
+        marked.push_back(i);
+      }
+    }
+    if (marked.empty() || n >= max_points) {
+      break;
+    }
+    // Over budget: keep the worst intervals, still in grid order.
+    std::size_t budget = max_points - n;
+    if (marked.size() > budget) {
+      std::nth_element(marked.begin(), marked.begin() + budget, marked.end(),
+                       [&](std::size_t l, std::size_t r) { return score[l] > score[r]; });
+      marked.resize(budget);
+      std::sort(marked.begin(), marked.end());
+    }
+
+    std::size_t m = marked.size();
+    std::vector<double> mx(m);
+    std::vector<double> my(m);
+    std::vector<double> md(m);
+    std::vector<double> md2(m);
+    for (std::size_t k = 0; k < m; ++k) {
+      std::size_t i = marked[k];
+      mx[k] = grid.x[i] + 0.5 * (grid.x[i + 1] - grid.x[i]);
+    }
+    evalReference(f, df, mx, my, md, md2);
+
+    GridData next;
+    next.a = a;
+    next.h = h0;
+    next.uniform = false;
+    next.x.reserve(n + m);
+    next.y.reserve(n + m);
+    next.d_true.reserve(n + m);
+    std::vector<double> next_d2;
+    next_d2.reserve(n + m);
+    std::size_t k = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+      next.x.push_back(grid.x[i]);
+      next.y.push_back(grid.y[i]);
+      next.d_true.push_back(grid.d_true[i]);
+      next_d2.push_back(d2[i]);
+      if (k < m && marked[k] == i) {
+        next.x.push_back(mx[k]);
+        next.y.push_back(my[k]);
+        next.d_true.push_back(md[k]);
+        next_d2.push_back(md2[k]);
+        ++k;
+      }
+    }
+    grid = std::move(next);
+    d2 = std::move(next_d2);
+  }
+  return grid;
+}
+
+}
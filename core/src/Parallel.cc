@@ -0,0 +1,27 @@
+#include "Parallel.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace matan {
+
+void setThreadCount(int threads) {
+#ifdef _OPENMP
+  if (threads > 0) {
+    omp_set_num_threads(threads);
+  }
+#else
+  (void)threads;
+#endif
+}
+
+int threadCount() {
+#ifdef _OPENMP
+  return omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
+}
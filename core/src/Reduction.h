@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace matan {
+
+// One Kahan-Neumaier step: the rounding error of sum + x goes into carry. Written as selects
+// rather than a branch so lane loops vectorize.
+inline void neumaierAdd(double& sum, double& carry, double x) {
+  double t = sum + x;
+  bool keep = std::fabs(sum) >= std::fabs(x);
+  double big = keep ? sum : x;
+  double small = keep ? x : sum;
+  carry += (big - t) + small;
+  sum = t;
+}
+
+struct NeumaierSum {
+  double sum = 0.0;
+  double carry = 0.0;
+
+  void add(double x) {
+    neumaierAdd(sum, carry, x);
+  }
+
+  double value() const {
+    return sum + carry;
+  }
+};
+
+// Compensated sum of (a[i] - b[i])^2. Terms go round-robin into kLanes independent Neumaier
+// accumulators which are then merged in lane order; the result depends only on the inputs.
+inline double sumSquaredDifferences(const double* a, const double* b, std::size_t n) {
+  constexpr std::size_t kLanes = 4;
+  double sum[kLanes] = {};
+  double carry[kLanes] = {};
+  std::size_t body = n - n % kLanes;
+  for (std::size_t i = 0; i < body; i += kLanes) {
+    for (std::size_t l = 0; l < kLanes; ++l) {
+      double e = a[i + l] - b[i + l];
+      neumaierAdd(sum[l], carry[l], e * e);
+    }
+  }
+  for (std::size_t i = body; i < n; ++i) {
+    double e = a[i] - b[i];
+    neumaierAdd(sum[i - body], carry[i - body], e * e);
+  }
+
+  NeumaierSum total;
+  for (std::size_t l = 0; l < kLanes; ++l) {
+    total.add(sum[l]);
+  }
+  for (std::size_t l = 0; l < kLanes; ++l) {
+    total.add(carry[l]);
+  }
+  return total.value();
+}
+
+// Pairwise combination of per-block partials with a fixed tree: partials are pushed in order onto
+// a carry stack that merges equal-sized subtrees, like a binary counter, and the leftover subtrees
+// are folded from the smallest up. The tree depends only on the number of partials, so a streaming
+// consumer and a batch consumer of the same partials get the same bits, in O(log n) memory.
+class PairwiseSum {
+ public:
+  void add(double x) {
+    std::uint32_t level = 0;
+    while (!levels_.empty() && levels_.back() == level) {
+      x = values_.back() + x;
+      values_.pop_back();
+      levels_.pop_back();
+      ++level;
+    }
+    values_.push_back(x);
+    levels_.push_back(level);
+  }
+
+  double value() const {
+    if (values_.empty()) {
+      return 0.0;
+    }
+    double acc = values_.back();
+    for (std::size_t k = values_.size() - 1; k-- > 0;) {
+      acc = values_[k] + acc;
+    }
+    return acc;
+  }
+
+ private:
+  std::vector<double> values_;
+  std::vector<std::uint32_t> levels_;
+};
+
+inline double pairwiseSum(const std::vector<double>& partials) {
+  PairwiseSum sum;
+  for (double p : partials) {
+    sum.add(p);
+  }
+  return sum.value();
+}
+
+}
@@ -1,9 +1,13 @@
 #include "ResultWriter.h"
 
+#include <array>
+#include <cmath>
+#include <cstddef>
 #include <filesystem>
 #include <fstream>
 #include <iomanip>
 #include <stdexcept>
+#include <vector>
 
 #include "Expression.h"
 
@@ -45,9 +49,11 @@ void removeTaskFiles(const std::string& dir, const std::string& prefix) {
 }
 
 void writeTask1Result(const MinimizationResult& result, const std::string& func_expr, double a,
-                      double b, const std::string& data_dir) {
+                      double b, const std::string& data_dir, bool trace_streamed) {
   ensureDir(data_dir);
-  removeTaskFiles(data_dir, "task1_");
+  if (!trace_streamed) {
+    removeTaskFiles(data_dir, "task1_");
+  }
 
   const std::string suffix = methodSuffix(result.method);
   const std::string func_path = data_dir + "/task1_func.dat";
@@ -65,25 +71,34 @@ void writeTask1Result(const MinimizationResult& result, const std::string& func_
     out << std::setprecision(17);
     const int samples = 400;
     const double step = (b - a) / static_cast<double>(samples);
+    std::vector<double> fx(samples + 1);
+    requireFinite(f.evalGrid(a, step, fx.size(), fx));
     for (int i = 0; i <= samples; ++i) {
       double x = a + step * static_cast<double>(i);
-      out << x << " " << f.eval(x) << "\n";
+      out << x << " " << fx[i] << "\n";
     }
   }
 
-  {
+  if (!trace_streamed) {
     std::ofstream out(points_path);
     if (!out) {
       throw std::runtime_error("Failed to open " + points_path);
     }
     out << std::setprecision(17);
+    std::vector<double> xs;
+    xs.reserve(result.iterations.size());
     for (const auto& it : result.iterations) {
-      double fx = f.eval(it.x_star);
-      out << it.k << " " << it.x_star << " " << fx << "\n";
+      xs.push_back(it.x_star);
+    }
+    std::vector<double> fx(xs.size());
+    requireFinite(f.evalBatch(xs, fx));
+    for (std::size_t i = 0; i < xs.size(); ++i) {
+      const auto& it = result.iterations[i];
+      out << it.k << " " << it.x_star << " " << fx[i] << "\n";
     }
   }
 
-  {
+  if (!trace_streamed) {
     std::ofstream out(interval_path);
     if (!out) {
       throw std::runtime_error("Failed to open " + interval_path);
@@ -99,7 +114,58 @@ void writeTask1Result(const MinimizationResult& result, const std::string& func_
     if (!out) {
       throw std::runtime_error("Failed to open " + summary_path);
     }
-    out << std::setprecision(17) << result.x_min << " " << result.f_min << "\n";
+    out << std::setprecision(17) << result.x_min << " " << result.f_min << " "
+        << result.evaluations << "\n";
+  }
+
+  if (!result.minima.empty()) {
+    const std::string minima_path = data_dir + "/task1_minima.dat";
+    std::ofstream out(minima_path);
+    if (!out) {
+      throw std::runtime_error("Failed to open " + minima_path);
+    }
+    out << std::setprecision(17);
+    for (std::size_t i = 0; i < result.minima.size(); ++i) {
+      out << i << " " << result.minima[i].x << " " << result.minima[i].f << "\n";
+    }
+  }
+
+  if (std::isfinite(result.f_lower)) {
+    const std::string bound_path = data_dir + "/task1_bound.dat";
+    std::ofstream out(bound_path);
+    if (!out) {
+      throw std::runtime_error("Failed to open " + bound_path);
+    }
+    out << std::setprecision(17) << result.f_lower << " " << result.f_min << "\n";
+  }
+}
+
+Task1TraceWriter::Task1TraceWriter(const std::string& data_dir, const std::string& func_expr,
+                                   const std::string& method)
+    : f_(func_expr) {
+  ensureDir(data_dir);
+  removeTaskFiles(data_dir, "task1_");
+
+  const std::string suffix = methodSuffix(method);
+  const std::string points_path = data_dir + "/task1_" + suffix + "_points.dat";
+  points_out_.open(points_path);
+  if (!points_out_) {
+    throw std::runtime_error("Failed to open " + points_path);
+  }
+  const std::string interval_path = data_dir + "/task1_" + suffix + "_interval.dat";
+  interval_out_.open(interval_path);
+  if (!interval_out_) {
+    throw std::runtime_error("Failed to open " + interval_path);
+  }
+  points_out_ << std::setprecision(17);
+  interval_out_ << std::setprecision(17);
+}
+
+void Task1TraceWriter::write(const IterationState& state) {
+  points_out_ << state.k << " " << state.x_star << " " << f_.eval(state.x_star) << "\n";
+  interval_out_ << state.k << " " << state.a << " " << state.b << " " << state.length << "\n";
+  if (!points_out_ || !interval_out_) {
+    throw std::runtime_error("Failed to write task1 output");
   }
 }
 
@@ -115,8 +181,13 @@ void writeTask2Result(const DerivativeResult& result, const std::string& data_di
     throw std::runtime_error("Failed to open " + path);
   }
   out << std::setprecision(17);
-  for (const auto& s : result.samples) {
-    out << s.x << " " << s.fx << " " << s.d_true << " " << s.d_est << " " << s.err << "\n";
+  for (std::size_t i = 0; i < result.size(); ++i) {
+    out << result.x(i) << " " << result.fx(i) << " " << result.d_true(i) << " " << result.d_est[i]
+        << " " << result.err(i);
+    if (!result.step.empty()) {
+      out << " " << result.step[i];
+    }
+    out << "\n";
   }
 }
 
@@ -131,7 +202,8 @@ void writeTask2Rmse(const std::vector<Task2RmseRow>& sweep, const std::string& d
   out << std::setprecision(17);
 
   for (const auto& r : sweep) {
-    out << r.h << " " << r.right << " " << r.left << " " << r.central << "\n";
+    out << r.h << " " << r.right << " " << r.left << " " << r.central << " " << r.central4 << " "
+        << r.central6 << " " << r.central8 << " " << r.richardson << "\n";
   }
 }
 
@@ -144,18 +216,63 @@ void writeTask2Combined(const Task2Results& results, const std::string& data_dir
     throw std::runtime_error("Failed to open " + path);
   }
 
-  const auto& right = results.right.samples;
-  const auto& left = results.left.samples;
-  const auto& central = results.central.samples;
-
-  if (right.size() != left.size() || right.size() != central.size()) {
-    throw std::runtime_error("Mismatched sample sizes in task2 results");
+  const std::array<const DerivativeResult*, kTask2Methods> columns = {
+      &results.right,    &results.left,     &results.central,   &results.central4,
+      &results.central6, &results.central8, &results.richardson};
+  const auto& grid = results.right.grid;
+  for (const auto* column : columns) {
+    if (column->grid != grid || column->size() != grid->size()) {
+      throw std::runtime_error("Mismatched grids in task2 results");
+    }
   }
 
+  // The first six columns are the original layout; higher-order estimates are appended.
   out << std::setprecision(17);
-  for (size_t i = 0; i < right.size(); ++i) {
-    out << right[i].x << " " << right[i].fx << " " << right[i].d_true << " " << right[i].d_est
-        << " " << left[i].d_est << " " << central[i].d_est << "\n";
+  for (std::size_t i = 0; i < grid->size(); ++i) {
+    out << grid->x(i) << " " << grid->fx[i] << " " << grid->d_true[i];
+    for (const auto* column : columns) {
+      out << " " << column->d_est[i];
+    }
+    out << "\n";
+  }
+}
+
+Task2StreamWriter::Task2StreamWriter(const std::string& data_dir, Task2Method method)
+    : column_(task2Column(method)) {
+  if (column_ >= kTask2Methods) {
+    throw std::runtime_error("Streaming is not supported for task2 method: " + toString(method));
+  }
+  ensureDir(data_dir);
+  removeTaskFiles(data_dir, "task2_");
+
+  const std::string method_path = data_dir + "/task2_" + toString(method) + ".dat";
+  method_out_.open(method_path);
+  if (!method_out_) {
+    throw std::runtime_error("Failed to open " + method_path);
+  }
+  const std::string all_path = data_dir + "/task2_all.dat";
+  all_out_.open(all_path);
+  if (!all_out_) {
+    throw std::runtime_error("Failed to open " + all_path);
+  }
+  method_out_ << std::setprecision(17);
+  all_out_ << std::setprecision(17);
+}
+
+void Task2StreamWriter::write(const Task2Chunk& chunk) {
+  const auto& d_est = chunk.d_est;
+  for (size_t k = 0; k < chunk.x.size(); ++k) {
+    double d = d_est[column_][k];
+    method_out_ << chunk.x[k] << " " << chunk.fx[k] << " " << chunk.d_true[k] << " " << d << " "
+                << d - chunk.d_true[k] << "\n";
+    all_out_ << chunk.x[k] << " " << chunk.fx[k] << " " << chunk.d_true[k];
+    for (const auto& column : d_est) {
+      all_out_ << " " << column[k];
+    }
+    all_out_ << "\n";
+  }
+  if (!method_out_ || !all_out_) {
+    throw std::runtime_error("Failed to write task2 output");
   }
 }
 
@@ -0,0 +1,33 @@
+#include "RichardsonDifference.h"
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "DiffCommon.h"
+#include "Parallel.h"
+#include "Stencil.h"
+
+namespace matan {
+
+RichardsonDifference::RichardsonDifference() : Differentiator("richardson") {}
+
+DerivativeResult RichardsonDifference::differentiate(const DifferentiationContext& ctx) const {
+  requireUniformGrid(ctx, "richardson");
+  auto grid = buildGrid(ctx.f, ctx.df, ctx.a, ctx.b, ctx.h);
+  auto fine = refineGrid(ctx.f, ctx.df, grid, ctx.a);
+  auto d_h = applyScheme<CentralScheme>(grid.y, grid.h);
+  auto d_half = applyScheme<CentralScheme>(fine.y, fine.h);
+
+  std::vector<double> d_est(grid.x.size());
+  std::size_t blocks = gridBlockCount(d_est.size());
+  MATAN_OMP_PARALLEL_FOR
+  for (std::ptrdiff_t blk = 0; blk < static_cast<std::ptrdiff_t>(blocks); ++blk) {
+    std::size_t begin = static_cast<std::size_t>(blk) * kGridBlock;
+    std::size_t end = gridBlockEnd(static_cast<std::size_t>(blk), d_est.size());
+    runRichardson(d_h.data() + begin, d_half.data() + 2 * begin, end - begin, d_est.data() + begin);
+  }
+  return makeResult(shareGrid(std::move(grid)), std::move(d_est));
+}
+
+}
@@ -0,0 +1,231 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "DiffCommon.h"
+#include "Parallel.h"
+
+namespace matan {
+
+// Finite-difference stencil with integer weights: f'(x_i) ~ sum(C[k] * y[i + Lo + k]) / (Den * h).
+// Terms are summed left to right and zero weights are skipped, so Stencil<-1, 2, -1, 0, 1> is
+// exactly (y[i + 1] - y[i - 1]) / (2 * h).
+template <int Lo, int Den, int... C>
+struct Stencil {
+  static constexpr int kLo = Lo;
+  static constexpr int kHi = Lo + static_cast<int>(sizeof...(C)) - 1;
+
+  static double apply(const double* y, std::size_t i, double h) {
+    return sum(y + i + Lo, std::make_index_sequence<sizeof...(C) - 1>{}) /
+           (static_cast<double>(Den) * h);
+  }
+
+ private:
+  static constexpr std::array<int, sizeof...(C)> kWeights = {C...};
+  static_assert(kWeights.front() != 0 && kWeights.back() != 0, "stencil has zero end weights");
+
+  template <int W>
+  static void addTerm(double& s, double y) {
+    if constexpr (W != 0) {
+      s += static_cast<double>(W) * y;
+    }
+  }
+
+  template <std::size_t... K>
+  static double sum(const double* y, std::index_sequence<K...>) {
+    double s = static_cast<double>(kWeights[0]) * y[0];
+    (addTerm<kWeights[K + 1]>(s, y[K + 1]), ...);
+    return s;
+  }
+};
+
+template <std::size_t N>
+struct StencilWeights {
+  long long den = 1;
+  std::array<long long, N> w{};
+};
+
+// Exact first-derivative weights at offset 0 over the nodes lo .. lo + N - 1, i.e. the derivative
+// of the Lagrange interpolant, scaled to integers over the smallest common denominator.
+template <std::size_t N>
+constexpr StencilWeights<N> derivativeWeights(int lo) {
+  std::array<long long, N> num{};
+  std::array<long long, N> den{};
+  long long common = 1;
+  for (std::size_t k = 0; k < N; ++k) {
+    long long ok = lo + static_cast<long long>(k);
+    long long d = 1;
+    long long s = 0;
+    for (std::size_t l = 0; l < N; ++l) {
+      if (l == k) {
+        continue;
+      }
+      d *= ok - (lo + static_cast<long long>(l));
+      long long p = 1;
+      for (std::size_t m = 0; m < N; ++m) {
+        if (m != k && m != l) {
+          p *= -(lo + static_cast<long long>(m));
+        }
+      }
+      s += p;
+    }
+    long long g = std::gcd(s, d);
+    num[k] = (d < 0 ? -s : s) / g;
+    den[k] = (d < 0 ? -d : d) / g;
+    common = std::lcm(common, den[k]);
+  }
+  StencilWeights<N> out;
+  out.den = common;
+  for (std::size_t k = 0; k < N; ++k) {
+    out.w[k] = num[k] * (common / den[k]);
+  }
+  return out;
+}
+
+template <int Lo, std::size_t N>
+struct ExactStencilOf {
+  static constexpr StencilWeights<N> kW = derivativeWeights<N>(Lo);
+
+  template <std::size_t... K>
+  static auto make(std::index_sequence<K...>)
+      -> Stencil<Lo, static_cast<int>(kW.den), static_cast<int>(kW.w[K])...>;
+
+  using type = decltype(make(std::make_index_sequence<N>{}));
+};
+
+// Highest-order stencil over the N nodes starting at offset Lo.
+template <int Lo, std::size_t N>
+using ExactStencil = typename ExactStencilOf<Lo, N>::type;
+
+// Stencils for the nodes next to one end of the grid; the j-th one serves the node j steps in.
+template <class... Stencils>
+struct EdgeStencils {
+  static constexpr std::size_t kCount = sizeof...(Stencils);
+  static constexpr std::size_t kMaxWidth =
+      std::max({std::size_t{0}, static_cast<std::size_t>(Stencils::kHi - Stencils::kLo + 1)...});
+
+  static double apply([[maybe_unused]] const double* y, [[maybe_unused]] std::size_t j,
+                      [[maybe_unused]] std::size_t i, [[maybe_unused]] double h) {
+    double d = std::numeric_limits<double>::quiet_NaN();
+    if constexpr (kCount > 0) {
+      std::size_t k = 0;
+      static_cast<void>(((k++ == j ? (d = Stencils::apply(y, i, h), true) : false) || ...));
+    }
+    return d;
+  }
+};
+
+// Interior stencil plus the edge stencils used on the nodes it cannot reach.
+template <class Interior, class LeftEdges, class RightEdges>
+struct Scheme {
+  static constexpr std::size_t kLeftNodes = Interior::kLo < 0 ? -Interior::kLo : 0;
+  static constexpr std::size_t kRightNodes = Interior::kHi > 0 ? Interior::kHi : 0;
+  static constexpr std::size_t kMinPoints =
+      std::max({kLeftNodes + kRightNodes + 1, static_cast<std::size_t>(Interior::kHi -
+                                                                       Interior::kLo + 1),
+                LeftEdges::kMaxWidth, RightEdges::kMaxWidth});
+  static_assert(LeftEdges::kCount >= kLeftNodes && RightEdges::kCount >= kRightNodes,
+                "scheme is missing edge stencils");
+
+  // Estimates for nodes [begin, end) of an n-node grid, written to out[0 .. end - begin). y holds
+  // nodes y0 .. y0 + y.size() - 1 and must cover every node the stencils reach. Edge nodes are
+  // peeled off so the interior loop has no branches. Grids too short for the scheme get NaN.
+  static void run(std::span<const double> y, std::size_t y0, std::size_t n, double h,
+                  std::size_t begin, std::size_t end, double* out) {
+    if (n < kMinPoints) {
+      std::fill(out, out + (end - begin), std::numeric_limits<double>::quiet_NaN());
+      return;
+    }
+    std::size_t lo_end = std::clamp(kLeftNodes, begin, end);
+    std::size_t hi_begin = std::clamp(n - kRightNodes, lo_end, end);
+    const double* yp = y.data();
+    for (std::size_t i = begin; i < lo_end; ++i) {
+      out[i - begin] = LeftEdges::apply(yp, i, i - y0, h);
+    }
+    for (std::size_t i = lo_end; i < hi_begin; ++i) {
+      out[i - begin] = Interior::apply(yp, i - y0, h);
+    }
+    for (std::size_t i = hi_begin; i < end; ++i) {
+      out[i - begin] = RightEdges::apply(yp, n - 1 - i, i - y0, h);
+    }
+  }
+
+  static void run(std::span<const double> y, double h, std::size_t begin, std::size_t end,
+                  double* out) {
+    run(y, 0, y.size(), h, begin, end, out);
+  }
+};
+
+using RightScheme = Scheme<ExactStencil<0, 2>, EdgeStencils<>, EdgeStencils<ExactStencil<-2, 3>>>;
+using LeftScheme = Scheme<ExactStencil<-1, 2>, EdgeStencils<ExactStencil<0, 3>>, EdgeStencils<>>;
+
+// Central stencil of the given even order; the Order / 2 nodes at each end use off-centre
+// stencils over the Order + 1 nearest nodes, which keeps the same order of accuracy.
+template <int Order>
+struct CentralSchemeOf {
+  static_assert(Order >= 2 && Order % 2 == 0, "central schemes have even order");
+  static constexpr std::size_t kPoints = Order + 1;
+
+  template <std::size_t... J>
+  static auto make(std::index_sequence<J...>)
+      -> Scheme<ExactStencil<-Order / 2, kPoints>,
+                EdgeStencils<ExactStencil<-static_cast<int>(J), kPoints>...>,
+                EdgeStencils<ExactStencil<static_cast<int>(J) - Order, kPoints>...>>;
+
+  using type = decltype(make(std::make_index_sequence<Order / 2>{}));
+};
+
+template <int Order>
+using CentralOrderScheme = typename CentralSchemeOf<Order>::type;
+
+using CentralScheme = CentralOrderScheme<2>;
+
+// Richardson extrapolation of a second-order estimate from steps h and h / 2.
+inline double richardson(double d_h, double d_half) {
+  return (4.0 * d_half - d_h) / 3.0;
+}
+
+// Richardson estimates for count consecutive coarse nodes. d_half holds the central estimate on
+// the grid refined once, starting at the fine node of the first coarse node, so coarse node k sits
+// at d_half[2k].
+inline void runRichardson(const double* d_h, const double* d_half, std::size_t count,
+                          double* out) {
+  for (std::size_t k = 0; k < count; ++k) {
+    out[k] = richardson(d_h[k], d_half[2 * k]);
+  }
+}
+
+// Runs every scheme over the same block of nodes; out[s] receives the estimates of scheme s.
+template <class... Schemes>
+void runSchemes(std::span<const double> y, std::size_t y0, std::size_t n, double h,
+                std::size_t begin, std::size_t end,
+                const std::array<double*, sizeof...(Schemes)>& out) {
+  std::size_t s = 0;
+  (Schemes::run(y, y0, n, h, begin, end, out[s++]), ...);
+}
+
+// Whole-grid estimate of one scheme, computed in parallel blocks.
+template <class S>
+std::vector<double> applyScheme(std::span<const double> y, double h) {
+  if (y.size() < S::kMinPoints) {
+    throw std::runtime_error("Invalid grid: too few points for the difference scheme");
+  }
+  std::vector<double> d(y.size());
+  std::size_t blocks = gridBlockCount(y.size());
+  MATAN_OMP_PARALLEL_FOR
+  for (std::ptrdiff_t blk = 0; blk < static_cast<std::ptrdiff_t>(blocks); ++blk) {
+    std::size_t begin = static_cast<std::size_t>(blk) * kGridBlock;
+    S::run(y, h, begin, gridBlockEnd(static_cast<std::size_t>(blk), y.size()), d.data() + begin);
+  }
+  return d;
+}
+
+}
@@ -1,22 +1,70 @@
 #include "Task1.h"
 
+#include "BrentMinimizer.h"
 #include "DichotomyMinimizer.h"
 #include "Expression.h"
+#include "FibonacciMinimizer.h"
+#include "GlobalMinimizer.h"
 #include "GoldenSectionMinimizer.h"
+#include "IntervalMinimizer.h"
+#include "KSectionMinimizer.h"
+#include "NewtonMinimizer.h"
 
 namespace matan {
 
 TaskResult Task1Dichotomy::run(const TaskContext& ctx) const {
   Expression expr(ctx.func);
   DichotomyMinimizer minimizer(ctx.delta);
-  MinimizationContext mctx{expr, ctx.a, ctx.b, ctx.eps};
+  MinimizationContext mctx{expr, ctx.a, ctx.b, ctx.eps, ctx.budget, ctx.trace};
   return minimizer.minimize(mctx);
 }
 
 TaskResult Task1Golden::run(const TaskContext& ctx) const {
   Expression expr(ctx.func);
   GoldenSectionMinimizer minimizer;
-  MinimizationContext mctx{expr, ctx.a, ctx.b, ctx.eps};
+  MinimizationContext mctx{expr, ctx.a, ctx.b, ctx.eps, ctx.budget, ctx.trace};
+  return minimizer.minimize(mctx);
+}
+
+TaskResult Task1Brent::run(const TaskContext& ctx) const {
+  Expression expr(ctx.func);
+  BrentMinimizer minimizer;
+  MinimizationContext mctx{expr, ctx.a, ctx.b, ctx.eps, ctx.budget, ctx.trace};
+  return minimizer.minimize(mctx);
+}
+
+TaskResult Task1Newton::run(const TaskContext& ctx) const {
+  Expression expr(ctx.func);
+  NewtonMinimizer minimizer;
+  MinimizationContext mctx{expr, ctx.a, ctx.b, ctx.eps, ctx.budget, ctx.trace};
+  return minimizer.minimize(mctx);
+}
+
+TaskResult Task1Global::run(const TaskContext& ctx) const {
+  Expression expr(ctx.func);
+  GlobalMinimizer minimizer(ctx.samples);
+  MinimizationContext mctx{expr, ctx.a, ctx.b, ctx.eps, ctx.budget, ctx.trace};
+  return minimizer.minimize(mctx);
+}
+
+TaskResult Task1KSection::run(const TaskContext& ctx) const {
+  Expression expr(ctx.func);
+  KSectionMinimizer minimizer(ctx.sections);
+  MinimizationContext mctx{expr, ctx.a, ctx.b, ctx.eps, ctx.budget, ctx.trace};
+  return minimizer.minimize(mctx);
+}
+
+TaskResult Task1Fibonacci::run(const TaskContext& ctx) const {
+  Expression expr(ctx.func);
+  FibonacciMinimizer minimizer;
+  MinimizationContext mctx{expr, ctx.a, ctx.b, ctx.eps, ctx.budget, ctx.trace};
+  return minimizer.minimize(mctx);
+}
+
+TaskResult Task1Interval::run(const TaskContext& ctx) const {
+  Expression expr(ctx.func);
+  IntervalMinimizer minimizer;
+  MinimizationContext mctx{expr, ctx.a, ctx.b, ctx.eps, ctx.budget, ctx.trace};
   return minimizer.minimize(mctx);
 }
 
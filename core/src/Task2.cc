@@ -1,32 +1,52 @@
 #include "Task2.h"
 
+#include "AdaptiveDifference.h"
 #include "CentralDifference.h"
+#include "DiffCommon.h"
 #include "Expression.h"
+#include "HighOrderCentralDifference.h"
 #include "LeftDifference.h"
+#include "RichardsonDifference.h"
 #include "RightDifference.h"
 #include "Task2Runner.h"
 
 namespace matan {
 
-TaskResult Task2Right::run(const TaskContext& ctx) const {
+namespace {
+
+// f and the optional analytic dfunc are compiled once and shared by the whole run.
+DerivativeResult differentiateWith(const Differentiator& method, const TaskContext& ctx) {
   Expression f(ctx.func);
-  RightDifference method;
-  DifferentiationContext dctx{f, f, ctx.a, ctx.b, ctx.h};
+  auto df = compileDerivative(ctx.dfunc);
+  DifferentiationContext dctx{f, df ? &*df : nullptr, ctx.a, ctx.b, ctx.h, ctx.tol, ctx.grid,
+                              ctx.max_points};
   return method.differentiate(dctx);
 }
 
+}
+
+TaskResult Task2Right::run(const TaskContext& ctx) const {
+  return differentiateWith(RightDifference(), ctx);
+}
+
 TaskResult Task2Left::run(const TaskContext& ctx) const {
-  Expression f(ctx.func);
-  LeftDifference method;
-  DifferentiationContext dctx{f, f, ctx.a, ctx.b, ctx.h};
-  return method.differentiate(dctx);
+  return differentiateWith(LeftDifference(), ctx);
 }
 
 TaskResult Task2Central::run(const TaskContext& ctx) const {
-  Expression f(ctx.func);
-  CentralDifference method;
-  DifferentiationContext dctx{f, f, ctx.a, ctx.b, ctx.h};
-  return method.differentiate(dctx);
+  return differentiateWith(CentralDifference(), ctx);
+}
+
+TaskResult Task2HighOrderCentral::run(const TaskContext& ctx) const {
+  return differentiateWith(HighOrderCentralDifference(order_), ctx);
+}
+
+TaskResult Task2Richardson::run(const TaskContext& ctx) const {
+  return differentiateWith(RichardsonDifference(), ctx);
+}
+
+TaskResult Task2Adaptive::run(const TaskContext& ctx) const {
+  return differentiateWith(AdaptiveDifference(), ctx);
 }
 
 }
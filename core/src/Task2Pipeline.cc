@@ -0,0 +1,141 @@
+#include "Task2Pipeline.h"
+
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <variant>
+
+#include "AdaptiveDifference.h"
+#include "DiffCommon.h"
+#include "Expression.h"
+#include "Task2Stages.h"
+#include "TaskFactory.h"
+
+namespace matan {
+
+namespace {
+
+constexpr std::array<DerivativeResult Task2Results::*, kTask2Methods> kColumns = {
+    &Task2Results::right,    &Task2Results::left,     &Task2Results::central,
+    &Task2Results::central4, &Task2Results::central6, &Task2Results::central8,
+    &Task2Results::richardson};
+
+}
+
+struct Task2Pipeline::Stages {
+  Stages(const TaskContext& context, Task2Method m, int steps)
+      : ctx(context),
+        method(m),
+        rmse_steps(steps),
+        f(context.func),
+        df(compileDerivative(context.dfunc)) {}
+
+  const Expression* derivative() const {
+    return df ? &*df : nullptr;
+  }
+
+  DifferentiationContext differentiationContext() const {
+    return {f, derivative(), ctx.a, ctx.b, ctx.h, ctx.tol, ctx.grid, ctx.max_points};
+  }
+
+  bool uniform() const {
+    return ctx.grid == GridKind::Uniform;
+  }
+
+  // grid is consumed by combined and fine by rmseSweep; each consumer runs once, after every
+  // other reader of its input.
+  GridData& grid() {
+    if (!grid_) {
+      grid_ = buildGrid(f, derivative(), ctx.a, ctx.b, ctx.h);
+    }
+    return *grid_;
+  }
+
+  GridData& fine() {
+    if (!fine_) {
+      fine_ = refineGrid(f, derivative(), grid(), ctx.a);
+    }
+    return *fine_;
+  }
+
+  const Task2Results& combined() {
+    if (!combined_) {
+      if (uniform()) {
+        const GridData& refined = fine();
+        combined_ = allDifferencesOn(std::move(grid()), refined);
+        grid_.reset();
+      } else {
+        combined_ = runAllDifferencesAdaptive(ctx.func, ctx.dfunc, ctx.a, ctx.b, ctx.h, ctx.tol,
+                                              ctx.max_points);
+      }
+    }
+    return *combined_;
+  }
+
+  const DerivativeResult& result() {
+    if (!result_) {
+      std::size_t column = task2Column(method);
+      if (!uniform()) {
+        result_ = std::get<DerivativeResult>(createTask2(method)->run(ctx));
+      } else if (column < kTask2Methods) {
+        result_ = combined().*kColumns[column];
+      } else if (method == Task2Method::Adaptive) {
+        result_ = AdaptiveDifference().differentiateOn(differentiationContext(),
+                                                       combined().right.grid);
+      } else {
+        throw std::runtime_error("Unknown method for task2");
+      }
+    }
+    return *result_;
+  }
+
+  const std::vector<Task2RmseRow>& rmseSweep() {
+    if (!sweep_) {
+      std::vector<Task2RmseRow> rows;
+      if (!uniform()) {
+        rows = runRmseSweep(ctx.func, ctx.dfunc, ctx.a, ctx.b, ctx.h, rmse_steps);
+      } else if (rmse_steps > 0) {
+        rows.reserve(static_cast<std::size_t>(rmse_steps));
+        rows.push_back(rmseRowOf(combined()));
+        continueRmseSweep(f, derivative(), ctx.a, std::move(fine()), rmse_steps - 1, rows);
+        fine_.reset();
+      }
+      sweep_ = std::move(rows);
+    }
+    return *sweep_;
+  }
+
+  TaskContext ctx;
+  Task2Method method;
+  int rmse_steps;
+  Expression f;
+  std::optional<Expression> df;
+
+ private:
+  std::optional<GridData> grid_;
+  std::optional<GridData> fine_;
+  std::optional<Task2Results> combined_;
+  std::optional<DerivativeResult> result_;
+  std::optional<std::vector<Task2RmseRow>> sweep_;
+};
+
+Task2Pipeline::Task2Pipeline(const TaskContext& ctx, Task2Method method, int rmse_steps)
+    : stages_(std::make_unique<Stages>(ctx, method, rmse_steps)) {}
+
+Task2Pipeline::~Task2Pipeline() = default;
+
+const DerivativeResult& Task2Pipeline::result() {
+  return stages_->result();
+}
+
+const Task2Results& Task2Pipeline::combined() {
+  return stages_->combined();
+}
+
+const std::vector<Task2RmseRow>& Task2Pipeline::rmseSweep() {
+  return stages_->rmseSweep();
+}
+
+}
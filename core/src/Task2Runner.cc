@@ -1,168 +1,373 @@
 #include "Task2Runner.h"
 
+#include <algorithm>
+#include <array>
 #include <cmath>
-#include <sstream>
+#include <cstddef>
+#include <limits>
+#include <span>
+#include <utility>
+#include <vector>
 
 #include "DiffCommon.h"
 #include "Expression.h"
-
-#ifdef _OPENMP
-#include <omp.h>
-#endif
+#include "NonUniformGrid.h"
+#include "Parallel.h"
+#include "Reduction.h"
+#include "Stencil.h"
+#include "Task2Stages.h"
 
 namespace matan {
 
 namespace {
 
-void fillSample(DerivativeSample& sample, int i, double x, double fx, double d_true,
-                double d_est) {
-  sample.i = i;
-  sample.x = x;
-  sample.fx = fx;
-  sample.d_true = d_true;
-  sample.d_est = d_est;
-  sample.err = d_est - d_true;
-}
+constexpr std::size_t kSchemes = kTask2Methods;
+constexpr std::size_t kCentral = 2;
+constexpr std::size_t kRichardson = 6;
 
-}
+// Nodes on each side of a block that any of its stencils may read.
+constexpr std::size_t kHalo =
+    std::max({RightScheme::kMinPoints, LeftScheme::kMinPoints, CentralOrderScheme<8>::kMinPoints}) -
+    1;
 
-Task2RmseRow computeRmseRow(const std::string& f_str, double a, double b, double h) {
-  Expression f(f_str);
-  auto grid = buildGrid(f, a, b, h);
+using BlockOutputs = std::array<double*, kSchemes>;
 
-  Task2RmseRow row;
-  row.h = grid.h;
+struct BlockEstimates {
+  std::array<std::vector<double>, kSchemes> d;
 
-  const auto& x = grid.x;
-  const auto& y = grid.y;
-  int n = static_cast<int>(x.size());
+  BlockEstimates() {
+    for (auto& v : d) {
+      v.resize(kGridBlock);
+    }
+  }
 
-  double sum_right = 0.0;
-  double sum_left = 0.0;
-  double sum_central = 0.0;
+  BlockOutputs outputs() {
+    BlockOutputs out{};
+    for (std::size_t s = 0; s < kSchemes; ++s) {
+      out[s] = d[s].data();
+    }
+    return out;
+  }
+};
 
-  for (int i = 0; i < n; ++i) {
-    double d_true = f.derivative(x[i]);
+// Every scheme over nodes [begin, end) of an n-node grid, in column order; y holds nodes from y0
+// on. d_half is the central estimate on the grid refined once, starting at fine node 2 * begin.
+void runBlock(std::span<const double> y, std::size_t y0, std::size_t n, double h,
+              const double* d_half, std::size_t begin, std::size_t end, const BlockOutputs& out) {
+  runSchemes<RightScheme, LeftScheme, CentralScheme, CentralOrderScheme<4>,
+             CentralOrderScheme<6>, CentralOrderScheme<8>>(
+      y, y0, n, h, begin, end, {out[0], out[1], out[2], out[3], out[4], out[5]});
+  runRichardson(out[kCentral], d_half, end - begin, out[kRichardson]);
+}
 
-    double d_right = 0.0;
-    if (i == n - 1) {
-      d_right = rightBoundaryDerivative(y, grid.h);
-    } else {
-      d_right = (y[i + 1] - y[i]) / grid.h;
-    }
+struct SchemePartials {
+  std::array<std::vector<double>, kSchemes> sum_sq;
 
-    double d_left = 0.0;
-    if (i == 0) {
-      d_left = leftBoundaryDerivative(y, grid.h);
-    } else {
-      d_left = (y[i] - y[i - 1]) / grid.h;
+  explicit SchemePartials(std::size_t blocks) {
+    for (auto& p : sum_sq) {
+      p.resize(blocks);
     }
+  }
 
-    double d_central = 0.0;
-    if (i == 0) {
-      d_central = leftBoundaryDerivative(y, grid.h);
-    } else if (i == n - 1) {
-      d_central = rightBoundaryDerivative(y, grid.h);
-    } else {
-      d_central = (y[i + 1] - y[i - 1]) / (2.0 * grid.h);
+  std::array<double, kSchemes> totals() const {
+    std::array<double, kSchemes> out{};
+    for (std::size_t s = 0; s < kSchemes; ++s) {
+      out[s] = pairwiseSum(sum_sq[s]);
     }
-
-    double err = d_right - d_true;
-    sum_right += err * err;
-    err = d_left - d_true;
-    sum_left += err * err;
-    err = d_central - d_true;
-    sum_central += err * err;
+    return out;
   }
+};
 
+Task2RmseRow makeRmseRow(double h, const std::array<double, kSchemes>& sum_sq, std::size_t n) {
   double denom = static_cast<double>(n);
-  row.right = std::sqrt(sum_right / denom);
-  row.left = std::sqrt(sum_left / denom);
-  row.central = std::sqrt(sum_central / denom);
+  Task2RmseRow row;
+  row.h = h;
+  row.right = std::sqrt(sum_sq[0] / denom);
+  row.left = std::sqrt(sum_sq[1] / denom);
+  row.central = std::sqrt(sum_sq[2] / denom);
+  row.central4 = std::sqrt(sum_sq[3] / denom);
+  row.central6 = std::sqrt(sum_sq[4] / denom);
+  row.central8 = std::sqrt(sum_sq[5] / denom);
+  row.richardson = std::sqrt(sum_sq[6] / denom);
   return row;
 }
 
-Task2Results runAllDifferences(const std::string& f_str, double a, double b, double h) {
-  Expression f(f_str);
-  auto grid = buildGrid(f, a, b, h);
+Task2RmseRow computeRmseRow(const GridData& grid, const GridData& fine) {
+  std::size_t n = grid.x.size();
+  std::size_t blocks = gridBlockCount(n);
+  auto d_half = applyScheme<CentralScheme>(fine.y, fine.h);
+  SchemePartials partials(blocks);
+
+  MATAN_OMP_PARALLEL_FOR
+  for (std::ptrdiff_t blk = 0; blk < static_cast<std::ptrdiff_t>(blocks); ++blk) {
+    thread_local BlockEstimates est;
+    std::size_t begin = static_cast<std::size_t>(blk) * kGridBlock;
+    std::size_t end = gridBlockEnd(static_cast<std::size_t>(blk), n);
+    runBlock(grid.y, 0, n, grid.h, d_half.data() + 2 * begin, begin, end, est.outputs());
+    for (std::size_t s = 0; s < kSchemes; ++s) {
+      partials.sum_sq[s][blk] =
+          sumSquaredDifferences(est.d[s].data(), grid.d_true.data() + begin, end - begin);
+    }
+  }
+
+  return makeRmseRow(grid.h, partials.totals(), n);
+}
+
+// Window of one streamed block: coarse nodes [lo, hi) around [begin, end) and the fine nodes
+// [2 * lo, 2 * hi - 1) of the grid refined once.
+struct StreamBlock {
+  std::size_t begin = 0;
+  std::size_t end = 0;
+  std::size_t lo = 0;
+  std::size_t hi = 0;
+  std::vector<double> x;
+  std::vector<double> y;
+  std::vector<double> d;
+  std::vector<double> mid_x;
+  std::vector<double> mid_y;
+  std::vector<double> mid_d;
+  std::vector<double> fine_y;
+  std::vector<double> d_half;
+  JetStatus status;
+  JetStatus mid_status;
+  BlockEstimates est;
+  std::array<double, kSchemes> sum_sq{};
+};
+
+void streamBlock(const Expression& f, const Expression* df, double a, double h, std::size_t n,
+                 std::size_t blk, StreamBlock& w) {
+  w.begin = blk * kGridBlock;
+  w.end = gridBlockEnd(blk, n);
+  w.lo = w.begin - std::min(w.begin, kHalo);
+  w.hi = std::min(n, w.end + kHalo);
+
+  std::size_t len = w.hi - w.lo;
+  w.x.resize(len);
+  w.y.resize(len);
+  w.d.resize(len);
+  for (std::size_t k = 0; k < len; ++k) {
+    w.x[k] = a + static_cast<double>(w.lo + k) * h;
+  }
+  w.status = evalWithReference(f, df, w.x, w.y, w.d);
+
+  // Same midpoints and values refineGrid would produce for these nodes.
+  double fine_h = h * 0.5;
+  std::size_t mids = len - 1;
+  w.mid_x.resize(mids);
+  w.mid_y.resize(mids);
+  w.mid_d.resize(mids);
+  for (std::size_t k = 0; k < mids; ++k) {
+    w.mid_x[k] = a + static_cast<double>(2 * (w.lo + k) + 1) * fine_h;
+  }
+  w.mid_status = evalWithReference(f, df, w.mid_x, w.mid_y, w.mid_d);
+  w.fine_y.resize(2 * mids + 1);
+  for (std::size_t k = 0; k < mids; ++k) {
+    w.fine_y[2 * k] = w.y[k];
+    w.fine_y[2 * k + 1] = w.mid_y[k];
+  }
+  w.fine_y[2 * mids] = w.y[mids];
 
-  const auto& x = grid.x;
-  const auto& y = grid.y;
-  int n = static_cast<int>(x.size());
+  std::size_t count = w.end - w.begin;
+  w.d_half.resize(2 * count - 1);
+  CentralScheme::run(w.fine_y, 2 * w.lo, 2 * n - 1, fine_h, 2 * w.begin, 2 * w.end - 1,
+                     w.d_half.data());
+  runBlock(w.y, w.lo, n, h, w.d_half.data(), w.begin, w.end, w.est.outputs());
+
+  const double* d_true = w.d.data() + (w.begin - w.lo);
+  for (std::size_t s = 0; s < kSchemes; ++s) {
+    w.sum_sq[s] = sumSquaredDifferences(w.est.d[s].data(), d_true, count);
+  }
+}
+
+}
+
+Task2Results allDifferencesOn(GridData&& grid, const GridData& fine) {
+  auto d_half = applyScheme<CentralScheme>(fine.y, fine.h);
+  std::size_t n = grid.x.size();
 
   Task2Results results;
-  results.right.method = "right";
-  results.left.method = "left";
-  results.central.method = "central";
-  results.right.h = grid.h;
-  results.left.h = grid.h;
-  results.central.h = grid.h;
-  results.right.samples.resize(x.size());
-  results.left.samples.resize(x.size());
-  results.central.samples.resize(x.size());
-
-  double sum_right = 0.0;
-  double sum_left = 0.0;
-  double sum_central = 0.0;
-
-  for (int i = 0; i < n; ++i) {
-    double xi = x[i];
-    double fx = y[i];
-    double d_true = f.derivative(xi);
-
-    double d_right = 0.0;
-    if (i == n - 1) {
-      d_right = rightBoundaryDerivative(y, grid.h);
-    } else {
-      d_right = (y[i + 1] - y[i]) / grid.h;
-    }
+  std::array<DerivativeResult*, kSchemes> out = {
+      &results.right,    &results.left,     &results.central,   &results.central4,
+      &results.central6, &results.central8, &results.richardson};
+  constexpr std::array<const char*, kSchemes> names = {
+      "right", "left", "central", "central4", "central6", "central8", "richardson"};
+  for (std::size_t s = 0; s < kSchemes; ++s) {
+    out[s]->method = names[s];
+    out[s]->h = grid.h;
+    out[s]->d_est.resize(n);
+  }
 
-    double d_left = 0.0;
-    if (i == 0) {
-      d_left = leftBoundaryDerivative(y, grid.h);
-    } else {
-      d_left = (y[i] - y[i - 1]) / grid.h;
-    }
+  std::size_t blocks = gridBlockCount(n);
+  SchemePartials partials(blocks);
 
-    double d_central = 0.0;
-    if (i == 0) {
-      d_central = leftBoundaryDerivative(y, grid.h);
-    } else if (i == n - 1) {
-      d_central = rightBoundaryDerivative(y, grid.h);
-    } else {
-      d_central = (y[i + 1] - y[i - 1]) / (2.0 * grid.h);
+  MATAN_OMP_PARALLEL_FOR
+  for (std::ptrdiff_t blk = 0; blk < static_cast<std::ptrdiff_t>(blocks); ++blk) {
+    std::size_t begin = static_cast<std::size_t>(blk) * kGridBlock;
+    std::size_t end = gridBlockEnd(static_cast<std::size_t>(blk), n);
+    BlockOutputs block_out{};
+    for (std::size_t s = 0; s < kSchemes; ++s) {
+      block_out[s] = out[s]->d_est.data() + begin;
+    }
+    runBlock(grid.y, 0, n, grid.h, d_half.data() + 2 * begin, begin, end, block_out);
+    for (std::size_t s = 0; s < kSchemes; ++s) {
+      partials.sum_sq[s][blk] =
+          sumSquaredDifferences(block_out[s], grid.d_true.data() + begin, end - begin);
     }
+  }
+
+  // One copy of x, fx and d_true serves all methods.
+  auto shared = shareGrid(std::move(grid));
+  auto sum_sq = partials.totals();
+  for (std::size_t s = 0; s < kSchemes; ++s) {
+    out[s]->grid = shared;
+    out[s]->rmse = std::sqrt(sum_sq[s] / static_cast<double>(n));
+  }
 
-    fillSample(results.right.samples[i], i, xi, fx, d_true, d_right);
-    fillSample(results.left.samples[i], i, xi, fx, d_true, d_left);
-    fillSample(results.central.samples[i], i, xi, fx, d_true, d_central);
+  return results;
+}
+
+Task2RmseRow rmseRowOf(const Task2Results& results) {
+  Task2RmseRow row;
+  row.h = results.right.h;
+  row.right = results.right.rmse;
+  row.left = results.left.rmse;
+  row.central = results.central.rmse;
+  row.central4 = results.central4.rmse;
+  row.central6 = results.central6.rmse;
+  row.central8 = results.central8.rmse;
+  row.richardson = results.richardson.rmse;
+  return row;
+}
 
-    double err = d_right - d_true;
-    sum_right += err * err;
-    err = d_left - d_true;
-    sum_left += err * err;
-    err = d_central - d_true;
-    sum_central += err * err;
+void continueRmseSweep(const Expression& f, const Expression* df, double a, GridData grid,
+                       int steps, std::vector<Task2RmseRow>& rows) {
+  // Each halving reuses every node of the previous level and evaluates only the new midpoints.
+  // Richardson at level k needs level k + 1, so the sweep always holds two consecutive levels.
+  for (int i = 0; i < steps; ++i) {
+    auto fine = refineGrid(f, df, grid, a);
+    rows.push_back(computeRmseRow(grid, fine));
+    grid = std::move(fine);
   }
+}
 
-  double denom = static_cast<double>(n);
-  results.right.rmse = std::sqrt(sum_right / denom);
-  results.left.rmse = std::sqrt(sum_left / denom);
-  results.central.rmse = std::sqrt(sum_central / denom);
+Task2Results runAllDifferences(const std::string& f_str, const std::string& df_str, double a,
+                               double b, double h) {
+  Expression f(f_str);
+  auto df = compileDerivative(df_str);
+  auto grid = buildGrid(f, df ? &*df : nullptr, a, b, h);
+  auto fine = refineGrid(f, df ? &*df : nullptr, grid, a);
+  return allDifferencesOn(std::move(grid), fine);
+}
+
+Task2Results runAllDifferencesAdaptive(const std::string& f_str, const std::string& df_str,
+                                       double a, double b, double h, double tol,
+                                       std::size_t max_points) {
+  Expression f(f_str);
+  auto df = compileDerivative(df_str);
+  auto grid = buildAdaptiveGrid(f, df ? &*df : nullptr, a, b, h, tol, 2, max_points);
+  std::size_t n = grid.x.size();
+
+  Task2Results results;
+  std::array<DerivativeResult*, kSchemes> out = {
+      &results.right,    &results.left,     &results.central,   &results.central4,
+      &results.central6, &results.central8, &results.richardson};
+  constexpr std::array<const char*, kSchemes> names = {
+      "right", "left", "central", "central4", "central6", "central8", "richardson"};
+  constexpr std::array<NonUniformScheme, 3> schemes = {
+      NonUniformScheme::Right, NonUniformScheme::Left, NonUniformScheme::Central};
+  for (std::size_t s = 0; s < kSchemes; ++s) {
+    out[s]->method = names[s];
+    out[s]->h = grid.h;
+    if (s < schemes.size()) {
+      out[s]->d_est = applyNonUniform(schemes[s], grid);
+      out[s]->rmse = rmseAgainst(out[s]->d_est, grid.d_true);
+    } else {
+      out[s]->d_est.assign(n, std::numeric_limits<double>::quiet_NaN());
+      out[s]->rmse = std::numeric_limits<double>::quiet_NaN();
+    }
+  }
 
+  auto shared = shareGrid(std::move(grid));
+  for (auto* result : out) {
+    result->grid = shared;
+  }
   return results;
 }
 
-std::vector<Task2RmseRow> runRmseSweep(const std::string& f_str, double a, double b, double h0,
-                                       int steps) {
+std::vector<Task2RmseRow> runRmseSweep(const std::string& f_str, const std::string& df_str,
+                                       double a, double b, double h0, int steps) {
   if (steps <= 0) {
     return {};
   }
+  Expression f(f_str);
+  auto df = compileDerivative(df_str);
   std::vector<Task2RmseRow> all;
   all.reserve(static_cast<std::size_t>(steps));
+  continueRmseSweep(f, df ? &*df : nullptr, a, buildGrid(f, df ? &*df : nullptr, a, b, h0), steps,
+                    all);
+  return all;
+}
+
+Task2RmseRow streamAllDifferences(const std::string& f_str, const std::string& df_str, double a,
+                                  double b, double h, const Task2ChunkSink& sink) {
+  Expression f(f_str);
+  auto df = compileDerivative(df_str);
+  std::size_t n = gridPointCount(a, b, h);
+  std::size_t blocks = gridBlockCount(n);
+  std::size_t wave = 2 * static_cast<std::size_t>(std::max(1, threadCount()));
+  std::vector<StreamBlock> slots(std::min(wave, blocks));
+
+  // Blocks of a wave run in parallel; their partial sums and chunks are consumed in grid order.
+  // The carry stack builds the same pairwise tree as the batch runners, so the sums match
+  // runAllDifferences bit for bit.
+  std::array<PairwiseSum, kSchemes> sum_sq;
+  for (std::size_t first = 0; first < blocks; first += slots.size()) {
+    std::size_t count = std::min(slots.size(), blocks - first);
+    MATAN_OMP_PARALLEL_FOR
+    for (std::ptrdiff_t k = 0; k < static_cast<std::ptrdiff_t>(count); ++k) {
+      streamBlock(f, df ? &*df : nullptr, a, h, n, first + static_cast<std::size_t>(k), slots[k]);
+    }
+    for (std::size_t k = 0; k < count; ++k) {
+      requireFinite(slots[k].status.f);
+      requireFinite(slots[k].mid_status.f);
+    }
+    for (std::size_t k = 0; k < count; ++k) {
+      requireFinite(slots[k].status.df, "Derivative");
+      requireFinite(slots[k].mid_status.df, "Derivative");
+    }
+    for (std::size_t k = 0; k < count; ++k) {
+      const auto& w = slots[k];
+      for (std::size_t s = 0; s < kSchemes; ++s) {
+        sum_sq[s].add(w.sum_sq[s]);
+      }
+      if (sink) {
+        std::size_t offset = w.begin - w.lo;
+        std::size_t len = w.end - w.begin;
+        Task2Chunk chunk;
+        chunk.begin = w.begin;
+        chunk.x = std::span<const double>(w.x).subspan(offset, len);
+        chunk.fx = std::span<const double>(w.y).subspan(offset, len);
+        chunk.d_true = std::span<const double>(w.d).subspan(offset, len);
+        for (std::size_t s = 0; s < kSchemes; ++s) {
+          chunk.d_est[s] = std::span<const double>(w.est.d[s]).first(len);
+        }
+        sink(chunk);
+      }
+    }
+  }
+  std::array<double, kSchemes> totals{};
+  for (std::size_t s = 0; s < kSchemes; ++s) {
+    totals[s] = sum_sq[s].value();
+  }
+  return makeRmseRow(h, totals, n);
+}
+
+std::vector<Task2RmseRow> streamRmseSweep(const std::string& f_str, const std::string& df_str,
+                                          double a, double b, double h0, int steps) {
+  std::vector<Task2RmseRow> all;
   double h = h0;
   for (int i = 0; i < steps; ++i) {
-    all.push_back(computeRmseRow(f_str, a, b, h));
+    all.push_back(streamAllDifferences(f_str, df_str, a, b, h));
     h *= 0.5;
   }
   return all;
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <vector>
+
+#include "DiffCommon.h"
+#include "Expression.h"
+#include "Task2Runner.h"
+
+namespace matan {
+
+// Grid-level steps of the Task2 runners, for callers that already hold the grids.
+
+// Every grid method on grid; fine is grid refined once and feeds Richardson. The columns of grid
+// move into the result grid shared by all methods.
+Task2Results allDifferencesOn(GridData&& grid, const GridData& fine);
+
+// RMSE row of results computed by allDifferencesOn (or runAllDifferences).
+Task2RmseRow rmseRowOf(const Task2Results& results);
+
+// Appends the RMSE rows of grid and its next steps - 1 halvings to rows.
+void continueRmseSweep(const Expression& f, const Expression* df, double a, GridData grid,
+                       int steps, std::vector<Task2RmseRow>& rows);
+
+}
@@ -15,20 +15,23 @@ std::unique_ptr<Task> createTask(const Config& cfg) {
           return std::make_unique<Task1Dichotomy>();
         case Task1Method::Golden:
           return std::make_unique<Task1Golden>();
+        case Task1Method::Brent:
+          return std::make_unique<Task1Brent>();
+        case Task1Method::Newton:
+          return std::make_unique<Task1Newton>();
+        case Task1Method::Global:
+          return std::make_unique<Task1Global>();
+        case Task1Method::KSection:
+          return std::make_unique<Task1KSection>();
+        case Task1Method::Fibonacci:
+          return std::make_unique<Task1Fibonacci>();
+        case Task1Method::Interval:
+          return std::make_unique<Task1Interval>();
         default:
           throw std::runtime_error("Unknown method for task1");
       }
     case TaskKind::Differentiate:
-      switch (cfg.task2.method) {
-        case Task2Method::Right:
-          return std::make_unique<Task2Right>();
-        case Task2Method::Left:
-          return std::make_unique<Task2Left>();
-        case Task2Method::Central:
-          return std::make_unique<Task2Central>();
-        default:
-          throw std::runtime_error("Unknown method for task2");
-      }
+      return createTask2(cfg.task2.method);
     default:
       break;
   }
@@ -36,4 +39,27 @@ std::unique_ptr<Task> createTask(const Config& cfg) {
   throw std::runtime_error("Unknown task");
 }
 
+std::unique_ptr<Task> createTask2(Task2Method method) {
+  switch (method) {
+    case Task2Method::Right:
+      return std::make_unique<Task2Right>();
+    case Task2Method::Left:
+      return std::make_unique<Task2Left>();
+    case Task2Method::Central:
+      return std::make_unique<Task2Central>();
+    case Task2Method::Central4:
+      return std::make_unique<Task2HighOrderCentral>(4);
+    case Task2Method::Central6:
+      return std::make_unique<Task2HighOrderCentral>(6);
+    case Task2Method::Central8:
+      return std::make_unique<Task2HighOrderCentral>(8);
+    case Task2Method::Richardson:
+      return std::make_unique<Task2Richardson>();
+    case Task2Method::Adaptive:
+      return std::make_unique<Task2Adaptive>();
+    default:
+      throw std::runtime_error("Unknown method for task2");
+  }
+}
+
 }
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Minimizer.h"
+
+namespace matan {
+
+// Iteration trace sinks. Every sink is called as sink(k, a, b, y, z, fy, fz) once per iteration
+// and finish() moves whatever it kept into the result. The minimizer loops are instantiated per
+// sink type, so with NoTrace they contain no trace code at all.
+
+inline IterationState makeIterationState(int k, double a, double b, double y, double z, double fy,
+                                         double fz) {
+  IterationState state;
+  state.k = k;
+  state.a = a;
+  state.b = b;
+  state.y = y;
+  state.z = z;
+  state.fy = fy;
+  state.fz = fz;
+  state.x_star = 0.5 * (a + b);
+  state.length = b - a;
+  return state;
+}
+
+struct NoTrace {
+  void operator()(int, double, double, double, double, double, double) {}
+  void finish(std::vector<IterationState>&) {}
+};
+
+class FullTrace {
+ public:
+  void operator()(int k, double a, double b, double y, double z, double fy, double fz) {
+    states_.push_back(makeIterationState(k, a, b, y, z, fy, fz));
+  }
+  void finish(std::vector<IterationState>& out) {
+    out = std::move(states_);
+  }
+
+ private:
+  std::vector<IterationState> states_;
+};
+
+// Keeps every `every`-th iteration and always the last one, so the final bracket is reported.
+class DecimatedTrace {
+ public:
+  explicit DecimatedTrace(int every) : every_(every) {}
+  void operator()(int k, double a, double b, double y, double z, double fy, double fz) {
+    held_ = seen_++ % every_ != 0;
+    if (held_) {
+      last_ = makeIterationState(k, a, b, y, z, fy, fz);
+    } else {
+      states_.push_back(makeIterationState(k, a, b, y, z, fy, fz));
+    }
+  }
+  void finish(std::vector<IterationState>& out) {
+    if (held_) {
+      states_.push_back(last_);
+    }
+    out = std::move(states_);
+  }
+
+ private:
+  int every_;
+  long long seen_ = 0;
+  bool held_ = false;
+  IterationState last_;
+  std::vector<IterationState> states_;
+};
+
+// Keeps the last `capacity` iterations in a ring and returns them oldest first.
+class LastTrace {
+ public:
+  explicit LastTrace(int capacity) : ring_(static_cast<std::size_t>(capacity)) {}
+  void operator()(int k, double a, double b, double y, double z, double fy, double fz) {
+    ring_[next_] = makeIterationState(k, a, b, y, z, fy, fz);
+    next_ = next_ + 1 == ring_.size() ? 0 : next_ + 1;
+    full_ = full_ || next_ == 0;
+  }
+  void finish(std::vector<IterationState>& out) {
+    out.clear();
+    if (full_) {
+      out.insert(out.end(), ring_.begin() + static_cast<std::ptrdiff_t>(next_), ring_.end());
+    }
+    out.insert(out.end(), ring_.begin(), ring_.begin() + static_cast<std::ptrdiff_t>(next_));
+  }
+
+ private:
+  std::vector<IterationState> ring_;
+  std::size_t next_ = 0;
+  bool full_ = false;
+};
+
+// Hands every iteration to the callback and keeps nothing.
+class StreamTrace {
+ public:
+  explicit StreamTrace(const TraceCallback& callback) : callback_(callback) {}
+  void operator()(int k, double a, double b, double y, double z, double fy, double fz) {
+    callback_(makeIterationState(k, a, b, y, z, fy, fz));
+  }
+  void finish(std::vector<IterationState>&) {}
+
+ private:
+  const TraceCallback& callback_;
+};
+
+// Calls run(make) with a factory for the sink type selected by `trace`; make() returns a fresh
+// sink, so a batch can give every problem its own.
+template <class Run>
+void withTraceSink(const TraceOptions& trace, Run&& run) {
+  switch (trace.mode) {
+    case TraceMode::None:
+      run([] { return NoTrace{}; });
+      break;
+    case TraceMode::Full:
+      run([] { return FullTrace{}; });
+      break;
+    case TraceMode::Every:
+      if (trace.every < 1) {
+        throw std::runtime_error("Invalid trace every: must be at least 1");
+      }
+      run([&] { return DecimatedTrace(trace.every); });
+      break;
+    case TraceMode::Last:
+      if (trace.last < 1) {
+        throw std::runtime_error("Invalid trace last: must be at least 1");
+      }
+      run([&] { return LastTrace(trace.last); });
+      break;
+    case TraceMode::Stream:
+      if (!trace.stream) {
+        throw std::runtime_error("Stream trace needs a callback");
+      }
+      run([&] { return StreamTrace(trace.stream); });
+      break;
+  }
+}
+
+// Runs body(result, sink) with the sink selected by `trace` and returns the result with the
+// method name and the kept iterations filled in.
+template <class Body>
+MinimizationResult runTraced(const TraceOptions& trace, const std::string& method, Body&& body) {
+  MinimizationResult result;
+  result.method = method;
+  withTraceSink(trace, [&](auto make) {
+    auto sink = make();
+    body(result, sink);
+    sink.finish(result.iterations);
+  });
+  return result;
+}
+
+}
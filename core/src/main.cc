@@ -1,8 +1,14 @@
+#include <cstddef>
 #include <iostream>
+#include <optional>
+#include <stdexcept>
 #include <variant>
+#include <vector>
 
 #include "Config.h"
+#include "Parallel.h"
 #include "ResultWriter.h"
+#include "Task2Pipeline.h"
 #include "Task2Runner.h"
 #include "TaskFactory.h"
 
@@ -14,26 +20,71 @@ int main(int argc, char** argv) {
 
   try {
     matan::Config cfg = matan::Config::load(config_path);
+    matan::setThreadCount(cfg.general.threads);
     matan::TaskContext ctx;
     ctx.func = cfg.general.func;
     ctx.dfunc = cfg.task2.dfunc;
     ctx.a = cfg.general.a;
     ctx.b = cfg.general.b;
     ctx.eps = cfg.task1.eps;
+    ctx.samples = cfg.task1.samples;
+    ctx.sections = cfg.task1.sections;
+    ctx.budget = cfg.task1.budget;
     ctx.h = cfg.task2.h;
+    ctx.tol = cfg.task2.tol;
+    ctx.grid = cfg.task2.grid;
+    ctx.max_points = static_cast<std::size_t>(cfg.task2.max_points);
+    bool adaptive_grid = ctx.grid == matan::GridKind::Adaptive;
 
-    auto task = matan::createTask(cfg);
-    auto result = task->run(ctx);
-    if (const auto* res_min = std::get_if<matan::MinimizationResult>(&result)) {
-      matan::writeTask1Result(*res_min, ctx.func, ctx.a, ctx.b, cfg.output.data_dir);
-    } else if (const auto* res_der = std::get_if<matan::DerivativeResult>(&result)) {
-      matan::writeTask2Result(*res_der, cfg.output.data_dir);
-      auto combined = matan::runAllDifferences(ctx.func, ctx.a, ctx.b, ctx.h);
-      matan::writeTask2Combined(combined, cfg.output.data_dir);
+    // Streaming keeps memory independent of the grid size: nothing is materialized and every
+    // output file is written chunk by chunk.
+    if (cfg.general.task == matan::TaskKind::Differentiate && cfg.task2.streaming) {
+      if (adaptive_grid) {
+        throw std::runtime_error("Streaming is not supported on adaptive grids");
+      }
+      matan::Task2StreamWriter writer(cfg.output.data_dir, cfg.task2.method);
+      auto first = matan::streamAllDifferences(
+          ctx.func, ctx.dfunc, ctx.a, ctx.b, ctx.h,
+          [&](const matan::Task2Chunk& chunk) { writer.write(chunk); });
       if (cfg.task2.rmse_sweep) {
-        auto sweep = matan::runRmseSweep(ctx.func, ctx.a, ctx.b, ctx.h, 5);
+        // The pass above is the first row; only the finer levels are streamed.
+        std::vector<matan::Task2RmseRow> sweep{first};
+        auto finer = matan::streamRmseSweep(ctx.func, ctx.dfunc, ctx.a, ctx.b, ctx.h * 0.5,
+                                            cfg.task2.rmse_steps - 1);
+        sweep.insert(sweep.end(), finer.begin(), finer.end());
         matan::writeTask2Rmse(sweep, cfg.output.data_dir);
       }
+      return 0;
+    }
+
+    // One pass serves every task2 output; see Task2Pipeline.
+    if (cfg.general.task == matan::TaskKind::Differentiate) {
+      matan::Task2Pipeline pipeline(ctx, cfg.task2.method, cfg.task2.rmse_steps);
+      matan::writeTask2Result(pipeline.result(), cfg.output.data_dir);
+      matan::writeTask2Combined(pipeline.combined(), cfg.output.data_dir);
+      if (cfg.task2.rmse_sweep) {
+        matan::writeTask2Rmse(pipeline.rmseSweep(), cfg.output.data_dir);
+      }
+      return 0;
+    }
+
+    // A streamed trace goes to disk as the minimizer runs instead of being kept in memory.
+    ctx.trace.mode = cfg.task1.trace;
+    ctx.trace.every = cfg.task1.trace_every;
+    ctx.trace.last = cfg.task1.trace_last;
+    std::optional<matan::Task1TraceWriter> trace_writer;
+    bool trace_streamed = cfg.general.task == matan::TaskKind::Minimize &&
+                          cfg.task1.trace == matan::TraceMode::Stream;
+    if (trace_streamed) {
+      trace_writer.emplace(cfg.output.data_dir, ctx.func, matan::toString(cfg.task1.method));
+      ctx.trace.stream = [&](const matan::IterationState& state) { trace_writer->write(state); };
+    }
+
+    auto task = matan::createTask(cfg);
+    auto result = task->run(ctx);
+    if (const auto* res_min = std::get_if<matan::MinimizationResult>(&result)) {
+      matan::writeTask1Result(*res_min, ctx.func, ctx.a, ctx.b, cfg.output.data_dir,
+                              trace_streamed);
     }
   } catch (const std::exception& ex) {
     std::cerr << "Error: " << ex.what() << std::endl;
@@ -0,0 +1,117 @@
+#include <iostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "BrentMinimizer.h"
+#include "Expression.h"
+#include "GoldenSectionMinimizer.h"
+
+// minimizeBatch must return exactly what minimize returns on each problem, although the lockstep
+// searches finish at different rounds and drop out of the batch one by one.
+namespace {
+
+int failures = 0;
+
+void fail(const std::string& what) {
+  std::cerr << what << "\n";
+  ++failures;
+}
+
+bool sameIterations(const matan::MinimizationResult& l, const matan::MinimizationResult& r) {
+  if (l.iterations.size() != r.iterations.size()) {
+    return false;
+  }
+  for (std::size_t i = 0; i < l.iterations.size(); ++i) {
+    const matan::IterationState& u = l.iterations[i];
+    const matan::IterationState& v = r.iterations[i];
+    if (u.k != v.k || u.a != v.a || u.b != v.b || u.y != v.y || u.z != v.z || u.fy != v.fy ||
+        u.fz != v.fz) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void check(const matan::Minimizer& minimizer, const char* name) {
+  matan::Expression f("sin(x) + x^2");
+  // Different widths, tolerances and budgets, so the searches finish at different rounds.
+  const std::vector<matan::MinimizationProblem> problems = {
+      {-2.0, 2.0, 1e-4, 0},   {-2.0, 2.0, 1e-10, 0}, {-1.0, 0.0, 1e-6, 0},
+      {-5.0, 3.0, 1e-8, 0},   {-2.0, 2.0, 1e-10, 7}, {0.0, 1.0, 1e-3, 0},
+      {-0.5, -0.4, 1e-12, 0}, {-3.0, 1.0, 1e-5, 20},
+  };
+  std::vector<matan::TraceOptions> modes(4);
+  modes[0].mode = matan::TraceMode::None;
+  modes[1].mode = matan::TraceMode::Full;
+  modes[2].mode = matan::TraceMode::Every;
+  modes[2].every = 3;
+  modes[3].mode = matan::TraceMode::Last;
+  modes[3].last = 5;
+  for (const matan::TraceOptions& options : modes) {
+    std::vector<matan::MinimizationResult> batch = minimizer.minimizeBatch(f, problems, options);
+    if (batch.size() != problems.size()) {
+      fail(std::string(name) + ": wrong result count");
+      continue;
+    }
+    for (std::size_t i = 0; i < problems.size(); ++i) {
+      const matan::MinimizationProblem& p = problems[i];
+      matan::MinimizationResult single =
+          minimizer.minimize({f, p.a, p.b, p.eps, p.budget, options});
+      if (batch[i].x_min != single.x_min || batch[i].f_min != single.f_min ||
+          batch[i].evaluations != single.evaluations || batch[i].method != single.method ||
+          !sameIterations(batch[i], single)) {
+        fail(std::string(name) + ": problem " + std::to_string(i) + " with trace mode " +
+             std::to_string(static_cast<int>(options.mode)) + " differs from minimize");
+      }
+    }
+  }
+
+  // A streamed batch keeps nothing and hands every iteration of every problem to the callback.
+  std::size_t full = 0;
+  for (const auto& r : minimizer.minimizeBatch(f, problems, modes[1])) {
+    full += r.iterations.size();
+  }
+  std::size_t streamed = 0;
+  matan::TraceOptions stream;
+  stream.mode = matan::TraceMode::Stream;
+  stream.stream = [&](const matan::IterationState&) { ++streamed; };
+  for (const auto& r : minimizer.minimizeBatch(f, problems, stream)) {
+    if (!r.iterations.empty()) {
+      fail(std::string(name) + ": streamed batch kept iterations");
+    }
+  }
+  if (streamed != full) {
+    fail(std::string(name) + ": streamed " + std::to_string(streamed) + " of " +
+         std::to_string(full) + " iterations");
+  }
+
+  // A point where f is not finite fails the whole batch, as it fails minimize.
+  matan::Expression pole("sqrt(x)");
+  const std::vector<matan::MinimizationProblem> bad = {{0.0, 1.0, 1e-6, 0},
+                                                       {-3.0, -1.0, 1e-6, 0}};
+  bool single_threw = false;
+  bool batch_threw = false;
+  try {
+    minimizer.minimize({pole, -3.0, -1.0, 1e-6});
+  } catch (const std::runtime_error&) {
+    single_threw = true;
+  }
+  try {
+    minimizer.minimizeBatch(pole, bad);
+  } catch (const std::runtime_error&) {
+    batch_threw = true;
+  }
+  if (!single_threw || !batch_threw) {
+    fail(std::string(name) + ": a non-finite f did not fail both minimize and minimizeBatch");
+  }
+}
+
+}
+
+int main() {
+  check(matan::GoldenSectionMinimizer(), "golden");
+  check(matan::BrentMinimizer(), "brent");
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,41 @@
+#include <cmath>
+#include <iostream>
+
+#include "Expression.h"
+#include "NewtonMinimizer.h"
+
+// The bracket the Newton minimizer maintains must close to eps around the returned minimum, and
+// the trace must report that bracket.
+int main() {
+  struct Case {
+    const char* func;
+    double a;
+    double b;
+    double eps;
+  };
+  const Case cases[] = {
+      {"sin(x) + x^2", -2.0, 2.0, 1e-4},
+      {"sin(x) + x^2", -2.0, 2.0, 1e-10},
+      {"x^4 - 3*x^3 + 2*x^2 + x", -1.0, 0.5, 1e-8},
+      {"(x - 1.7)^2", 0.0, 5.0, 1e-6},
+  };
+
+  int failures = 0;
+  matan::NewtonMinimizer minimizer;
+  for (const Case& c : cases) {
+    matan::Expression f(c.func);
+    matan::MinimizationResult result = minimizer.minimize({f, c.a, c.b, c.eps});
+    if (result.iterations.empty()) {
+      std::cerr << c.func << ": empty trace\n";
+      ++failures;
+      continue;
+    }
+    const matan::IterationState& last = result.iterations.back();
+    if (last.b - last.a > c.eps || result.x_min < last.a || result.x_min > last.b) {
+      std::cerr << c.func << " eps=" << c.eps << ": last bracket [" << last.a << ", " << last.b
+                << "], x_min=" << result.x_min << "\n";
+      ++failures;
+    }
+  }
+  return failures == 0 ? 0 : 1;
+}